@@ -0,0 +1,218 @@
+#include <algorithm>
+#include "Cardinality.h"
+using namespace std;
+
+// Number of literals per group in the commander encoding.
+const int kCommanderGroupSize = 3;
+
+void CardinalityEncoder::AtMost(const vector<Literal>& lits, int k)
+{
+	int n = lits.size();
+	if (k >= n)
+		return;
+	if (k < 0)
+	{
+		solver->AddClause(NULL, 0);
+		return;
+	}
+	if (k == 0)
+	{
+		for (int i = 0; i < n; i++)
+			solver->AddClause({-lits[i]});
+		return;
+	}
+
+	if (encoding == kPairwise)
+		PairwiseSubsets(lits, k + 1, -1);
+	else if (encoding == kCommander && k == 1)
+		CommanderAtMostOne(lits);
+	else
+	{
+		vector<Literal> count = (encoding == kSequentialCounter) ? SequentialCounter(lits, k + 1) : Totalizer(lits, 0, n, k + 1);
+		solver->AddClause({-count[k + 1]});
+	}
+}
+
+void CardinalityEncoder::Exactly(const vector<Literal>& lits, int k)
+{
+	int n = lits.size();
+	if (k < 0 || k > n)
+	{
+		solver->AddClause(NULL, 0);
+		return;
+	}
+	if (k == 0)
+	{
+		AtMost(lits, 0);
+		return;
+	}
+	if (k == n)
+	{
+		for (int i = 0; i < n; i++)
+			solver->AddClause({lits[i]});
+		return;
+	}
+
+	// Exactly one is at least one (a single clause) plus at most one.
+	if (k == 1 || encoding == kPairwise)
+	{
+		if (k == 1)
+			solver->AddClause(lits);
+		else
+			PairwiseSubsets(lits, n - k + 1, 1);
+		AtMost(lits, k);
+		return;
+	}
+	// A counter capped at k+1 answers both sides.
+	vector<Literal> count = (encoding == kSequentialCounter) ? SequentialCounter(lits, k + 1) : Totalizer(lits, 0, n, k + 1);
+	solver->AddClause({count[k]});
+	solver->AddClause({-count[k + 1]});
+}
+
+void CardinalityEncoder::PairwiseSubsets(const vector<Literal>& lits, int subset_size, int sign)
+{
+	// Walks the subsets as increasing index vectors.
+	int n = lits.size();
+	vector<int> index(subset_size);
+	for (int i = 0; i < subset_size; i++)
+		index[i] = i;
+
+	Clause clause(subset_size);
+	while (true)
+	{
+		for (int i = 0; i < subset_size; i++)
+			clause[i] = sign * lits[index[i]];
+		solver->AddClause(clause);
+
+		int i = subset_size - 1;
+		while (i >= 0 && index[i] == n - subset_size + i)
+			i--;
+		if (i < 0)
+			return;
+		index[i]++;
+		for (int j = i + 1; j < subset_size; j++)
+			index[j] = index[j - 1] + 1;
+	}
+}
+
+vector<Literal> CardinalityEncoder::SequentialCounter(const vector<Literal>& lits, int cap)
+{
+	// s[j] after input i stands for "at least j of lits[0..i] are true":
+	// s_i[j] <-> s_{i-1}[j] or (x_i and s_{i-1}[j-1]), with s[0] true and s[j] false before any input.
+	vector<Literal> prev(cap + 1, 0), count(cap + 1, 0);
+	for (int i = 0; i < (int) lits.size(); i++)
+	{
+		Literal x = lits[i];
+		for (int j = 1; j <= min(cap, i + 1); j++)
+		{
+			Literal s = NewVar();
+			count[j] = s;
+			bool has_prev = (j <= i);		// at least j of i inputs is possible
+			bool has_carry = (j >= 2);		// otherwise s_{i-1}[0] is true
+
+			if (has_prev)
+			{
+				solver->AddClause({-prev[j], s});
+				if (has_carry)
+					solver->AddClause({-s, prev[j], prev[j - 1]});
+				solver->AddClause({-s, prev[j], x});
+			}
+			else
+			{
+				if (has_carry)
+					solver->AddClause({-s, prev[j - 1]});
+				solver->AddClause({-s, x});
+			}
+			if (has_carry)
+				solver->AddClause({-x, -prev[j - 1], s});
+			else
+				solver->AddClause({-x, s});
+		}
+		prev = count;
+	}
+
+	// Counts beyond the number of inputs are false.
+	for (int j = lits.size() + 1; j <= cap; j++)
+	{
+		count[j] = NewVar();
+		solver->AddClause({-count[j]});
+	}
+	return count;
+}
+
+vector<Literal> CardinalityEncoder::Totalizer(const vector<Literal>& lits, int begin, int end, int cap)
+{
+	// A leaf counts itself. An inner node merges two halves, a (counting p inputs) and b (q inputs):
+	// out[i + l] follows from a[i] and b[l], and not out[i + l + 1] from not a[i + 1] and not b[l + 1],
+	// where a[0] and b[0] are true and a[p + 1] and b[q + 1] false.
+	int n = end - begin;
+	if (n == 1)
+		return vector<Literal>(2, lits[begin]);
+
+	int mid = begin + n / 2;
+	vector<Literal> a = Totalizer(lits, begin, mid, cap), b = Totalizer(lits, mid, end, cap);
+	int p = mid - begin, q = end - mid;
+	int cap_a = a.size() - 1, cap_b = b.size() - 1, cap_out = min(n, cap);
+
+	vector<Literal> out(cap_out + 1, 0);
+	for (int j = 1; j <= cap_out; j++)
+		out[j] = NewVar();
+
+	for (int i = 0; i <= cap_a; i++)
+		for (int l = 0; l <= cap_b; l++)
+		{
+			if (i + l >= 1)
+			{
+				Clause up;
+				if (i > 0)
+					up.push_back(-a[i]);
+				if (l > 0)
+					up.push_back(-b[l]);
+				up.push_back(out[min(i + l, cap_out)]);
+				solver->AddClause(up);
+			}
+
+			// Only counts below the cap are known to be at most i (l) when a[i + 1] (b[l + 1]) is false.
+			if (i + l + 1 <= cap_out && (i < cap_a || i == p) && (l < cap_b || l == q))
+			{
+				Clause down;
+				if (i < p)
+					down.push_back(a[i + 1]);
+				if (l < q)
+					down.push_back(b[l + 1]);
+				down.push_back(-out[i + l + 1]);
+				solver->AddClause(down);
+			}
+		}
+	return out;
+}
+
+Literal CardinalityEncoder::CommanderAtMostOne(const vector<Literal>& lits)
+{
+	// Small groups are handled pairwise. Otherwise split into groups of kCommanderGroupSize, each
+	// with a commander that is true exactly when one of its group is, and recurse on the commanders.
+	if (lits.size() <= kCommanderGroupSize)
+	{
+		for (size_t i = 0; i < lits.size(); i++)
+			for (size_t j = i + 1; j < lits.size(); j++)
+				solver->AddClause({-lits[i], -lits[j]});
+
+		if (lits.size() == 1)
+			return lits[0];
+		Literal c = NewVar();
+		Clause any(lits);
+		any.push_back(-c);
+		solver->AddClause(any);
+		for (size_t i = 0; i < lits.size(); i++)
+			solver->AddClause({-lits[i], c});
+		return c;
+	}
+
+	vector<Literal> commanders;
+	for (int g = 0; g < (int) lits.size(); g += kCommanderGroupSize)
+	{
+		vector<Literal> group(lits.begin() + g, lits.begin() + min<int>(g + kCommanderGroupSize, lits.size()));
+		commanders.push_back(CommanderAtMostOne(group));
+	}
+	return CommanderAtMostOne(commanders);
+}
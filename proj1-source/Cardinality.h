@@ -0,0 +1,52 @@
+#ifndef CARDINALITY_H
+#define CARDINALITY_H
+
+#include <vector>
+#include "SatSolver.h"
+
+// Ways of turning "at most / exactly k of these literals are true" into clauses.
+enum CardinalityEncoding
+{
+	kPairwise,				// no auxiliary variables; one clause per (k+1)-subset
+	kSequentialCounter,		// Sinz's counter: n * (k+1) auxiliary variables
+	kCommander,				// Klieber and Kwon's commander variables (k = 1; larger k use kTotalizer)
+	kTotalizer				// Bailleux and Boufkhad's totalizer, with counts capped at k+1
+};
+
+// Posts cardinality constraints to a SatSolver, allocating auxiliary variables from
+// 'first_free_var' upwards. Every auxiliary variable is defined by equivalences (a counter
+// output is true exactly when enough of its inputs are), so each model of the original variables
+// extends to exactly one model of the encoding, and counting models stays exact.
+class CardinalityEncoder
+{
+public:
+	CardinalityEncoder(SatSolver* solver, int first_free_var, CardinalityEncoding encoding)
+		{this->solver = solver;	next_var = first_free_var;	this->encoding = encoding;}
+
+	void AtMostOne(const std::vector<Literal>& lits)	{AtMost(lits, 1);}
+	void ExactlyOne(const std::vector<Literal>& lits)	{Exactly(lits, 1);}
+	void AtMost(const std::vector<Literal>& lits, int k);
+	void Exactly(const std::vector<Literal>& lits, int k);
+
+	int NextFreeVar() const	{return next_var;}
+
+private:
+	int NewVar()	{return next_var++;}
+
+	// Pairwise: every (k+1)-subset has a false literal; for at least k, every (n-k+1)-subset has a true one.
+	void PairwiseSubsets(const std::vector<Literal>& lits, int subset_size, int sign);
+
+	// Counters return 'count', where count[j] (1 <= j <= cap) is a literal that is true exactly
+	// when at least j of 'lits' are; count[0] is unused.
+	std::vector<Literal> SequentialCounter(const std::vector<Literal>& lits, int cap);
+	std::vector<Literal> Totalizer(const std::vector<Literal>& lits, int begin, int end, int cap);
+
+	// Commander: returns a literal that is true exactly when one of 'lits' is, after posting
+	// at-most-one over 'lits'.
+	Literal CommanderAtMostOne(const std::vector<Literal>& lits);
+
+	SatSolver* solver;
+	int next_var;
+	CardinalityEncoding encoding;
+};
+#endif
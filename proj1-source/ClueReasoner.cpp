@@ -1,32 +1,24 @@
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
 #include "ClueReasoner.h"
+#include "ModelCounter.h"
 using namespace std;
 
 int ClueReasoner::GetPlayerNum(string player)
 {
-	if (player == case_file)
-		return num_players;
-	
-	for (int i = 0; i < num_players; i++)
-		if (player == players[i])
-			return i;
-			
-	cout<<"Illegal player: "<<player<<endl;
-	return -1;
+	int id = config.PlaceId(player);
+	if (id < 0)
+		cout<<"Illegal player: "<<player<<endl;
+	return id;
 }
 
 int ClueReasoner::GetCardNum(string card)
 {
-	for (int i = 0; i < num_cards; i++)
-		if (card == cards[i])
-			return i;
-			
-	cout<<"Illegal card: "<<card<<endl;
-	return -1;
-}
-
-int ClueReasoner::GetPairNum(int player, int card) 
-{
-	return player * num_cards + card + 1;
+	int id = config.CardId(card);
+	if (id < 0)
+		cout<<"Illegal card: "<<card<<endl;
+	return id;
 }
 
 int ClueReasoner::GetPairNum(string player, string card) 
@@ -36,7 +28,24 @@ int ClueReasoner::GetPairNum(string player, string card)
 
 int ClueReasoner::Query(string player, string card) 
 {
-	return solver->TestLiteral(GetPairNum(player,card));
+	return Query(GetPlayerNum(player), GetCardNum(card));
+}
+
+int ClueReasoner::Query(int p, int c) 
+{
+	if (p < 0 || c < 0)
+		return solver->TestLiteral(GetPairNum(p, c));
+	
+	// Decided cells are answered from the notepad.
+	if (Cell(c, p) == kUnknown)
+	{
+		int result = solver->TestLiteral(GetPairNum(p, c));
+		if (result == kContradiction)
+			SetContradiction();
+		else if (result != kUnknown)
+			Decide(c, p, result);
+	}
+	return Cell(c, p);
 }
 
 string ClueReasoner::QueryString(int return_code)
@@ -51,25 +60,205 @@ string ClueReasoner::QueryString(int return_code)
 		return "X";
 }
 
+void ClueReasoner::Init(const GameConfig& config, CardinalityEncoding encoding)
+{
+	this->config = config;
+	this->encoding = encoding;
+	solver = new SatSolver();
+	player_num = -1;
+	ClearNotepad();
+	AddInitialClauses();
+}
+
+void ClueReasoner::ClearNotepad()
+{
+	notepad.assign(config.NumCards() * config.NumPlaces(), kUnknown);
+	places.assign(config.NumCards(), Bitset(config.NumPlaces(), true));
+	for (int k = 0; k < num_categories; k++)
+		case_file_cards[k] = Bitset(config.CategorySize(k), true);
+	notepad_dirty = true;
+	contradiction = false;
+}
+
+void ClueReasoner::SetContradiction()
+{
+	// Contradictory clauses stay contradictory, and then every cell is, decided or not.
+	contradiction = true;
+	notepad.assign(notepad.size(), kContradiction);
+}
+
+void ClueReasoner::Decide(int card, int place, int value)
+{
+	if (contradiction || card < 0 || place < 0 || Cell(card, place) == value)
+		return;
+	if (Cell(card, place) != kUnknown)
+	{
+		SetContradiction();
+		return;
+	}
+	Cell(card, place) = value;
+	
+	// The case file's cards are numbered within their category.
+	int cf = config.NumPlayers();
+	int category = config.CategoryOf(card);
+	int first = config.CategoryFirst(category);
+	int size = config.CategorySize(category);
+	
+	if (value == kTrue)
+	{
+		for (int p = 0; p < config.NumPlaces(); p++)
+			if (p != place)
+				Decide(card, p, kFalse);
+		
+		if (place == cf)
+			for (int c = first; c < first + size; c++)
+				if (c != card)
+					Decide(c, cf, kFalse);
+		return;
+	}
+	
+	places[card].Reset(place);
+	if (places[card].None())
+	{
+		SetContradiction();
+		return;
+	}
+	if (places[card].Single() >= 0)
+		Decide(card, places[card].Single(), kTrue);
+	
+	if (place == cf && !contradiction)
+	{
+		case_file_cards[category].Reset(card - first);
+		if (case_file_cards[category].None())
+			SetContradiction();
+		else if (case_file_cards[category].Single() >= 0)
+			Decide(first + case_file_cards[category].Single(), cf, kTrue);
+	}
+}
+
+void ClueReasoner::UpdateNotepad()
+{
+	if (!notepad_dirty)
+		return;
+	notepad_dirty = false;
+	
+	// Ask about the cells that Decide left open in one batch; cell i * NumPlaces() + j is card i at place j.
+	vector<Literal> literals;
+	vector<int> cells;
+	for (int i = 0; i < config.NumCards(); i++)
+		for (int j = 0; j < config.NumPlaces(); j++)
+			if (Cell(i, j) == kUnknown)
+			{
+				literals.push_back(GetPairNum(j, i));
+				cells.push_back(i * config.NumPlaces() + j);
+			}
+	if (literals.empty())
+		return;
+	vector<int> results = solver->TestLiterals(literals);
+	
+	if (results[0] == kContradiction)
+	{
+		SetContradiction();
+		return;
+	}
+	for (size_t k = 0; k < cells.size(); k++)
+		if (results[k] != kUnknown)
+			Decide(cells[k] / config.NumPlaces(), cells[k] % config.NumPlaces(), results[k]);
+}
+
 void ClueReasoner::PrintNotepad()
 {
-	for (int i = 0; i < num_players; i++)
-		cout<<"\t"<<players[i];
-	cout<<"\t"<<case_file<<endl;
+	UpdateNotepad();
 	
-	for (int i = 0; i < num_cards; i++)
+	for (int i = 0; i < config.NumPlaces(); i++)
+		cout<<"\t"<<config.PlaceName(i);
+	cout<<endl;
+	
+	for (int i = 0; i < config.NumCards(); i++)
 	{
-		cout<<cards[i]<<"\t";
-		for (int j = 0; j < num_players; j++)
-			cout<<QueryString(Query(players[j], cards[i]))<<"\t";
+		cout<<config.CardName(i)<<"\t";
+		for (int j = 0; j < config.NumPlayers(); j++)
+			cout<<QueryString(Cell(i, j))<<"\t";
 		
-		cout<<QueryString(Query(case_file, cards[i]))<<endl;
+		cout<<QueryString(Cell(i, config.NumPlayers()))<<endl;
 	}
 }
 	
+bool ClueReasoner::GetProbabilities(vector<vector<double> >& probability)
+{
+	// The rules go to the counter as they are, not as the solver's encoding of them: the
+	// encoding's auxiliary variables would tell apart the formulas left after dealing the same
+	// number of cards to each player in a different order, which the cache is there to catch.
+	// The clauses added since only mention places of cards, and so do the cells the notepad has
+	// settled, which are implied by them but save the counter some search.
+	const ClauseArena& clauses = solver->GetClauses();
+	ClauseArena known;
+	for (int i = num_rule_clauses; i < clauses.NumClauses(); i++)
+		known.Add(clauses.Begin(i), clauses.Size(i));
+	for (int c = 0; c < config.NumCards(); c++)
+		for (int p = 0; p < config.NumPlaces(); p++)
+			if (Cell(c, p) == kTrue || Cell(c, p) == kFalse)
+			{
+				Literal unit = (Cell(c, p) == kTrue) ? GetPairNum(p, c) : -GetPairNum(p, c);
+				known.Add(&unit, 1);
+			}
+	
+	ModelCounter counter(known, config.NumCards() * config.NumPlaces());
+	vector<Clause> rules;
+	vector<int> counts;
+	GetRules(rules, counts);
+	for (size_t i = 0; i < rules.size(); i++)
+		counter.AddExactly(rules[i], counts[i]);
+	
+	// Deciding card by card, each place in turn, leaves formulas that depend mostly on how many
+	// cards each player has been dealt so far rather than on which ones.
+	vector<int> order;
+	for (int c = 0; c < config.NumCards(); c++)
+		for (int p = 0; p < config.NumPlaces(); p++)
+			order.push_back(GetPairNum(p, c));
+	counter.SetDecisionOrder(order);
+	
+	vector<double> true_counts;
+	double count = counter.Count(&true_counts);
+	if (count == 0)
+		return false;
+	
+	probability.assign(config.NumCards(), vector<double>(config.NumPlaces()));
+	for (int c = 0; c < config.NumCards(); c++)
+		for (int p = 0; p < config.NumPlaces(); p++)
+			probability[c][p] = true_counts[GetPairNum(p, c)] / count;
+	return true;
+}
+
+void ClueReasoner::PrintProbabilities()
+{
+	vector<vector<double> > probability;
+	if (!GetProbabilities(probability))
+	{
+		cout<<"No consistent deal."<<endl;
+		return;
+	}
+	
+	for (int i = 0; i < config.NumPlaces(); i++)
+		cout<<"\t"<<config.PlaceName(i);
+	cout<<endl;
+	
+	ios::fmtflags flags = cout.flags();
+	streamsize precision = cout.precision();
+	for (int i = 0; i < config.NumCards(); i++)
+	{
+		cout<<config.CardName(i);
+		for (int j = 0; j < config.NumPlaces(); j++)
+			cout<<"\t"<<fixed<<setprecision(3)<<probability[i][j];
+		cout<<endl;
+	}
+	cout.flags(flags);
+	cout.precision(precision);
+}
+
 void ClueReasoner::AddInitialClauses()
 {
-	/* The following code is given as an example to show how to create Clauses and post them to the solver. SatSolver.h uses the following typedefs:
+	/* The rules of the game are posted to the solver as cardinality constraints (see Cardinality.h). SatSolver.h uses the following typedefs:
 		typedef int Literal;
 		typedef std::vector<Literal> Clause;
 		
@@ -79,181 +268,249 @@ void ClueReasoner::AddInitialClauses()
 	See ClueReasoner.h, lines 7-31 for a definition of the arrays and variables that you can use in your implementation. 
 	*/
 
-	// Each card is in at least one place (including the case file).
-	for (int c = 0; c < num_cards; c++)	// Iterate over all cards.
+	// With the totalizer and sequential counter encodings the clauses grow with cards * places for
+	// the first two rules and cards * hand size for the third, not with their squares.
+	CardinalityEncoder encoder(solver, GetPairNum(config.NumPlayers(), config.NumCards() - 1) + 1, encoding);
+	vector<Clause> rules;
+	vector<int> counts;
+	GetRules(rules, counts);
+	for (size_t i = 0; i < rules.size(); i++)
+		encoder.Exactly(rules[i], counts[i]);
+	num_rule_clauses = solver->NumClauses();
+}
+
+void ClueReasoner::GetRules(vector<Clause>& rules, vector<int>& counts)
+{
+	// Each card is in exactly one place (including the case file).
+	for (int c = 0; c < config.NumCards(); c++)
 	{
-		Clause clause;
-		for (int p = 0; p <= num_players; p++)	// Iterate over all players, including the case file (as a possible place for a card).
-			clause.push_back(GetPairNum(p, c)); // Add to the clause the literal that states 'p has c'.
-		
-		solver->AddClause(clause);
+		Clause places;
+		for (int p = 0; p < config.NumPlaces(); p++)
+			places.push_back(GetPairNum(p, c));
+		rules.push_back(places);
+		counts.push_back(1);
 	}
 	
-	// If a card is in one place, it cannot be in another place.
-    for(int c = 0; c < num_cards; c++) { //Iterate over all cards
-        vector<Clause> oneCardDisjunction; //A disjunction of a card being in one place
-        for(int p = 0; p <= num_players; p++) { //Iterate over all players
-            int playerIndex = p;
-            int nextPlayerIndex = (p == num_players) ? 0 : p + 1;
-            while(nextPlayerIndex != playerIndex) {
-                Clause clause;
-                clause.push_back(GetPairNum(playerIndex, c) * -1);
-                clause.push_back(GetPairNum(nextPlayerIndex, c) * -1);
-                solver->AddClause(clause);
-                nextPlayerIndex = (nextPlayerIndex == num_players) ? 0 : nextPlayerIndex + 1;
-            }
-        }
-    }
+	// Exactly one card of each category is in the case file.
+	for (int k = 0; k < num_categories; k++)
+	{
+		Clause case_file_cards;
+		for (int c = config.CategoryFirst(k); c < config.CategoryFirst(k) + config.CategorySize(k); c++)
+			case_file_cards.push_back(GetPairNum(config.NumPlayers(), c));
+		rules.push_back(case_file_cards);
+		counts.push_back(1);
+	}
 	
-	// At least one card of each category is in the case file.
-	/*
-        For this to happen, the case file must have one of the suspects, weapons, rooms, and cards. Can use a simple conjunction of disjunctions
-     */
-    Clause caseFileClause;
-    for(int i = 0; i < num_suspects; i++) {
-        caseFileClause.push_back(GetPairNum("cf", suspects[i]));
-    }
-    solver->AddClause(caseFileClause);
-    caseFileClause.clear();
-    
-    for(int i = 0; i < num_weapons; i++) {
-        caseFileClause.push_back(GetPairNum("cf", weapons[i]));
-    }
-    solver->AddClause(caseFileClause);
-    caseFileClause.clear();
-    
-    for(int i = 0; i < num_rooms; i++) {
-        caseFileClause.push_back(GetPairNum("cf", rooms[i]));
-    }
-    solver->AddClause(caseFileClause);
-    caseFileClause.clear();
-
-	// No two cards in each category can both be in the case file.
-	//Similar logic to no cards should be in two places, except if there's one card of a category in the case file, then every other card cannot be assigned to the case file
-    // If a card is in one place, it cannot be in another place.
-    for(int s = 0; s < num_suspects; s++) { //Iterate over suspect cards
-        int suspectIndex = s;
-        int nextSuspectIndex = (suspectIndex == num_suspects) ? 0 : s + 1;
-        while(nextSuspectIndex != suspectIndex) {
-            Clause clause;
-            clause.push_back(GetPairNum("cf", suspects[suspectIndex]) * -1);
-            clause.push_back(GetPairNum("cf", suspects[nextSuspectIndex]) * -1);
-            solver->AddClause(clause);
-            nextSuspectIndex = (nextSuspectIndex == num_suspects) ? 0 : nextSuspectIndex + 1;
-        }
-    }
-    
-    for(int w = 0; w < num_weapons; w++) { //Iterate over suspect cards
-        int weaponIndex = w;
-        int nextWeaponIndex = (weaponIndex == num_weapons) ? 0 : w + 1;
-        while(nextWeaponIndex != weaponIndex) {
-            Clause clause;
-            clause.push_back(GetPairNum("cf", weapons[weaponIndex]) * -1);
-            clause.push_back(GetPairNum("cf", weapons[nextWeaponIndex]) * -1);
-            solver->AddClause(clause);
-            nextWeaponIndex = (nextWeaponIndex == num_weapons) ? 0 : nextWeaponIndex + 1;
-        }
-    }
-    
-    for(int r = 0; r < num_rooms; r++) { //Iterate over suspect cards
-        int roomIndex = r;
-        int nextRoomIndex = (roomIndex == num_rooms) ? 0 : r + 1;
-        while(nextRoomIndex != roomIndex) {
-            Clause clause;
-            clause.push_back(GetPairNum("cf", weapons[roomIndex]) * -1);
-            clause.push_back(GetPairNum("cf", weapons[nextRoomIndex]) * -1);
-            solver->AddClause(clause);
-            nextRoomIndex = (nextRoomIndex == num_rooms) ? 0 : nextRoomIndex + 1;
-        }
-    }
+	// The cards outside the case file are dealt around the table, so every player holds exactly
+	// HandSize cards.
+	for (int p = 0; p < config.NumPlayers(); p++)
+	{
+		Clause hand;
+		for (int c = 0; c < config.NumCards(); c++)
+			hand.push_back(GetPairNum(p, c));
+		rules.push_back(hand);
+		counts.push_back(config.HandSize(p));
+	}
 }
 
 
 void ClueReasoner::Hand(string player, string cards[3])
 {
-	// GetPlayerNum returns the index of the player in the players array (not the suspects array). Remember that the players array is sorted wrt the order that the players play. Also note that, player_num (not to be confused with num_players) is a private variable of the ClueReasoner class that is initialized when this function is called.
-	player_num = GetPlayerNum(player);
-    for(int i = 0; i < 3; i++) {
-        Clause clause;
-        clause.push_back(GetPairNum(player, cards[i]));
-        solver->AddClause(clause);
-    }
+	vector<int> card_ids;
+	for (int i = 0; i < 3; i++)
+		card_ids.push_back(GetCardNum(cards[i]));
+	Hand(GetPlayerNum(player), card_ids);
+}
+
+void ClueReasoner::Hand(int player, const vector<int>& cards)
+{
+	// Note that player_num (not to be confused with num_players) is a private variable of the ClueReasoner class that is initialized when this function is called.
+	player_num = player;
+	notepad_dirty = true;
+	for (size_t i = 0; i < cards.size(); i++)
+	{
+		solver->AddClause({GetPairNum(player, cards[i])});
+		Decide(cards[i], player, kTrue);
+	}
 }
 
 void ClueReasoner::Suggest(string suggester, string card1, string card2, string card3, string refuter, string card_shown)
 {
 	// Note that in the Java implementation, the refuter and the card_shown can be NULL. 
-	// In this C++ implementation, NULL is translated to be the empty string "".
-	// To check if refuter is NULL or card_shown is NULL, you should use if(refuter == "") or if(card_shown == ""), respectively.
+	// In this C++ implementation, NULL is translated to be the empty string "", and to kNone for the integer overload.
+	Suggest(GetPlayerNum(suggester), GetCardNum(card1), GetCardNum(card2), GetCardNum(card3),
+			refuter == "" ? kNone : GetPlayerNum(refuter), card_shown == "" ? kNone : GetCardNum(card_shown));
+}
+
+void ClueReasoner::Suggest(int suggester, int card1, int card2, int card3, int refuter, int card_shown)
+{
+	notepad_dirty = true;
+	
+	// The players after the suggester, up to the refuter (or all of them if nobody refuted), do not have any of the suggested cards.
+	int suggested[3] = {card1, card2, card3};
+	int last = (refuter == kNone) ? suggester : refuter;
+	for (int p = (suggester + 1) % config.NumPlayers(); p != last; p = (p + 1) % config.NumPlayers())
+		for (int i = 0; i < 3; i++)
+		{
+			solver->AddClause({-GetPairNum(p, suggested[i])});
+			Decide(suggested[i], p, kFalse);
+		}
+	
+	if (refuter == kNone)
+		return;
 	
-    if(refuter == "") {
-        //no refuter at all --> all players except suggester do not have suggested cards
-        for(int i = 0; i < num_players; i++) {
-            if(players[i] != suggester) {
-                Clause clause1;
-                clause1.push_back(GetPairNum(players[i], card1) * -1);
-                solver->AddClause(clause1);
-                Clause clause2;
-                clause2.push_back(GetPairNum(players[i], card2) * -1);
-                solver->AddClause(clause2);
-                Clause clause3;
-                clause3.push_back(GetPairNum(players[i], card3) * -1);
-                solver->AddClause(clause3);
-            }
-        }
-    }
-    else {
-        int refuterIndex = (GetPlayerNum(suggester) == (num_players - 1)) ? 0 : GetPlayerNum(suggester) + 1;
-        int lastRefuterIndex = GetPlayerNum(refuter);
-        while(refuterIndex != lastRefuterIndex) {
-            //The players in between do not have the cards
-            Clause clause1;
-            clause1.push_back(GetPairNum(players[refuterIndex], card1) * -1);
-            solver->AddClause(clause1);
-            Clause clause2;
-            clause2.push_back(GetPairNum(players[refuterIndex], card2) * -1);
-            solver->AddClause(clause2);
-            Clause clause3;
-            clause3.push_back(GetPairNum(players[refuterIndex], card3) * -1);
-            solver->AddClause(clause3);
-            refuterIndex = (refuterIndex == (num_players - 1)) ? 0 : refuterIndex + 1;
-        }
-        
-        //we reach the refuter. In this case, we either can see the card shown or not
-        if(card_shown == "") {
-            //player does not get to see which card was shown upon refute
-            Clause clause1;
-            clause1.push_back(GetPairNum(players[refuterIndex], card1));
-            clause1.push_back(GetPairNum(players[refuterIndex], card2));
-            clause1.push_back(GetPairNum(players[refuterIndex], card3));
-            solver->AddClause(clause1);
-        } else {
-            //player gets to see which card was shown
-            Clause clause1;
-            clause1.push_back(GetPairNum(players[refuterIndex], card_shown));
-            solver->AddClause(clause1);
-        }
-    }
+	// The refuter has one of the cards; we may or may not get to see which.
+	if (card_shown == kNone)
+		solver->AddClause({GetPairNum(refuter, card1), GetPairNum(refuter, card2), GetPairNum(refuter, card3)});
+	else
+	{
+		solver->AddClause({GetPairNum(refuter, card_shown)});
+		Decide(card_shown, refuter, kTrue);
+	}
 }
 
 void ClueReasoner::Accuse(string suggester, string card1, string card2, string card3, bool is_correct)
 {
-	// TO BE IMPLEMENTED AS AN EXERCISE (you don't need to implement this)
+	Accuse(GetPlayerNum(suggester), GetCardNum(card1), GetCardNum(card2), GetCardNum(card3), is_correct);
 }
 
+void ClueReasoner::Accuse(int suggester, int card1, int card2, int card3, bool is_correct)
+{
+	notepad_dirty = true;
+	
+	// A correct accusation names the case file; a wrong one only rules out that combination.
+	int accused[3] = {card1, card2, card3};
+	int cf = config.NumPlayers();
+	if (is_correct)
+		for (int i = 0; i < 3; i++)
+		{
+			solver->AddClause({GetPairNum(cf, accused[i])});
+			Decide(accused[i], cf, kTrue);
+		}
+	else
+		solver->AddClause({-GetPairNum(cf, card1), -GetPairNum(cf, card2), -GetPairNum(cf, card3)});
+}
 
+bool ClueReasoner::GetSolution(int solution[num_categories])
+{
+	// The case file cells the notepad has not decided go to the solver in one batch.
+	int cf = config.NumPlayers();
+	vector<Literal> literals;
+	vector<int> open_cards;
+	for (int c = 0; c < config.NumCards() && !contradiction; c++)
+		if (Cell(c, cf) == kUnknown)
+		{
+			literals.push_back(GetPairNum(cf, c));
+			open_cards.push_back(c);
+		}
+	if (!literals.empty())
+	{
+		vector<int> results = solver->TestLiterals(literals);
+		if (results[0] == kContradiction)
+			SetContradiction();
+		for (size_t i = 0; i < open_cards.size() && !contradiction; i++)
+			if (results[i] != kUnknown)
+				Decide(open_cards[i], cf, results[i]);
+	}
+	
+	bool solved = !contradiction;
+	for (int k = 0; k < num_categories; k++)
+	{
+		solution[k] = kNone;
+		for (int c = config.CategoryFirst(k); c < config.CategoryFirst(k) + config.CategorySize(k) && !contradiction; c++)
+			if (Cell(c, cf) == kTrue)
+				solution[k] = c;
+		solved = solved && (solution[k] != kNone);
+	}
+	return solved;
+}
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+bool ClueReasoner::ReplayLog(istream& log)
+{
+	// One parsed line: the call, its place and card ids, and the accusation's outcome.
+	struct LogEntry
+	{
+		char type;		// 'h', 's' or 'a'
+		int player, refuter, card_shown;
+		vector<int> cards;	// the hand, or the three cards suggested or accused
+		bool is_correct;
+	};
+	vector<LogEntry> entries;
+	
+	string line, word;
+	for (int line_num = 1; getline(log, line); line_num++)
+	{
+		istringstream fields(line);
+		if (!(fields>>word) || word[0] == '#')
+			continue;
+		
+		LogEntry entry;
+		entry.type = word[0];
+		entry.refuter = entry.card_shown = kNone;
+		entry.is_correct = false;
+		bool ok = (word == "hand" || word == "suggest" || word == "accuse");
+		
+		entry.player = -1;
+		if (ok && fields>>word)
+			entry.player = config.PlaceId(word);
+		ok = ok && entry.player >= 0 && entry.player < config.NumPlayers();
+		
+		// A hand runs to the end of the line; the other calls name three cards.
+		int num_listed = (entry.type == 'h') ? (ok ? config.HandSize(entry.player) : 0) : 3;
+		while (ok && (int) entry.cards.size() < num_listed && fields>>word)
+		{
+			entry.cards.push_back(config.CardId(word));
+			ok = (entry.cards.back() >= 0);
+		}
+		ok = ok && (int) entry.cards.size() == num_listed;
+		
+		if (ok && entry.type == 's')
+		{
+			if (fields>>word && word != "-")
+				entry.refuter = config.PlaceId(word);
+			ok = fields && entry.refuter < config.NumPlayers() && (word == "-" || entry.refuter >= 0);
+			if (ok && fields>>word && word != "-")
+				entry.card_shown = config.CardId(word);
+			ok = fields && (word == "-" || entry.card_shown >= 0);
+			
+			// Only a refuter shows a card, and it has to be one of the three suggested.
+			if (ok && entry.card_shown != kNone)
+				ok = entry.refuter != kNone && find(entry.cards.begin(), entry.cards.end(), entry.card_shown) != entry.cards.end();
+		}
+		else if (ok && entry.type == 'a')
+			ok = !(fields>>entry.is_correct).fail();
+		ok = ok && !(fields>>word);
+		
+		if (!ok)
+		{
+			cout<<"Illegal log line "<<line_num<<": "<<line<<endl;
+			return false;
+		}
+		entries.push_back(entry);
+	}
+	
+	// A suggestion adds at most three units for each of the other players and a three-literal
+	// clause for the refuter; a hand adds a unit per card, and an accusation at most three literals.
+	int max_clauses = 0, max_literals = 0;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		int others = config.NumPlayers() - 1;
+		max_clauses += (entries[i].type == 's') ? 3 * others + 1 : entries[i].cards.size();
+		max_literals += (entries[i].type == 's') ? 3 * others + 3 : entries[i].cards.size();
+	}
+	solver->ReserveClauses(solver->NumClauses() + max_clauses, solver->NumLiterals() + max_literals);
+	
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const LogEntry& e = entries[i];
+		if (e.type == 'h')
+			Hand(e.player, e.cards);
+		else if (e.type == 's')
+			Suggest(e.player, e.cards[0], e.cards[1], e.cards[2], e.refuter, e.card_shown);
+		else
+			Accuse(e.player, e.cards[0], e.cards[1], e.cards[2], e.is_correct);
+	}
+	
+	UpdateNotepad();
+	return true;
+}
@@ -2,8 +2,11 @@
 #define CLUE_REASONER_H
 
 #include "SatSolver.h"
+#include "Cardinality.h"
+#include "GameConfig.h"
 #include <string>
 #include <vector>
+#include <istream>
 
 // 'players' array contains all the players, sorted wrt the order that the players play. 
 // The order is important for the 'suggest' function. 
@@ -20,6 +23,8 @@ const std::string weapons[6] = {"kn", "ca", "re", "ro", "pi", "wr"};
 const std::string rooms[9] = {"ha", "lo", "di", "ki", "ba", "co", "bi", "li", "st"};
 const std::string cards[21] = {"mu", "pl", "gr", "pe", "sc", "wh", "kn", "ca", "re", "ro", "pi", "wr", "ha", "lo", "di", "ki", "ba", "co", "bi", "li", "st"};
 
+// The arrays and variables above and below describe the standard game, which is what ClueReasoner
+// plays unless it is given another GameConfig (see GameConfig.h).
 // The variables below specify the number of elements in each array. 
 // You can iterate over all possible places, including the case_file, with a for loop: 
 // for (int i = 0; i <= num_players; i++). 
@@ -30,33 +35,163 @@ const int num_suspects = 6;
 const int num_weapons = 6;
 const int num_rooms = 9;
 const int num_cards = 21;
+const int hand_size = (num_cards - num_categories) / num_players;
+
+// Integer ids of the cards and places, in the order of the cards and players arrays above (the
+// case file is place num_players). The integer overloads of the ClueReasoner functions take these,
+// with kNone for "no refuter" or "no card shown".
+enum CardId
+{
+	kMu, kPl, kGr, kPe, kSc, kWh,
+	kKn, kCa, kRe, kRo, kPi, kWr,
+	kHa, kLo, kDi, kKi, kBa, kCo, kBi, kLi, kSt
+};
+enum PlaceId {kPlayerSc, kPlayerMu, kPlayerWh, kPlayerGr, kPlayerPe, kPlayerPl, kCaseFile};
+const int kNone = -1;
+
+// Cards first[k] .. first[k] + size[k] - 1 make up category k (suspects, weapons, rooms).
+constexpr int category_first[num_categories] = {0, num_suspects, num_suspects + num_weapons};
+constexpr int category_size[num_categories] = {num_suspects, num_weapons, num_rooms};
+constexpr int CategoryOf(int card)	{return card < num_suspects ? 0 : card < num_suspects + num_weapons ? 1 : 2;}
+
+// Name to id conversion without string comparisons: the hashes below are perfect on the card and
+// place names (checked at compile time), so a name takes one table lookup and one two-character
+// comparison.
+constexpr char card_names[num_cards][3] = {"mu", "pl", "gr", "pe", "sc", "wh", "kn", "ca", "re", "ro", "pi", "wr", "ha", "lo", "di", "ki", "ba", "co", "bi", "li", "st"};
+constexpr char place_names[num_players + 1][3] = {"sc", "mu", "wh", "gr", "pe", "pl", "cf"};
+
+constexpr int CardHash(const char* name)	{return ((unsigned char) name[0] * 30 + (unsigned char) name[1]) % 46;}
+constexpr int PlaceHash(const char* name)	{return ((unsigned char) name[0] * 6 + (unsigned char) name[1]) % 10;}
+
+template <int M>
+struct NameSlots
+{
+	signed char id[M];	// id of the name that hashes to each slot, -1 if none
+	bool perfect;		// no two names hash to the same slot
+};
+
+template <int M, int N>
+constexpr NameSlots<M> MakeNameSlots(const char (&names)[N][3], int (*hash)(const char*))
+{
+	NameSlots<M> slots = {};
+	for (int i = 0; i < M; i++)
+		slots.id[i] = -1;
+	slots.perfect = true;
+	for (int i = 0; i < N; i++)
+	{
+		if (slots.id[hash(names[i])] >= 0)
+			slots.perfect = false;
+		slots.id[hash(names[i])] = i;
+	}
+	return slots;
+}
+
+constexpr NameSlots<46> card_slots = MakeNameSlots<46>(card_names, CardHash);
+constexpr NameSlots<10> place_slots = MakeNameSlots<10>(place_names, PlaceHash);
+static_assert(card_slots.perfect, "CardHash must be perfect on card_names");
+static_assert(place_slots.perfect, "PlaceHash must be perfect on place_names");
+
+// Return the id of a card or place name, or -1 if there is no such name.
+constexpr int CardIdOf(const char* name)
+{
+	int id = (name[0] && name[1] && !name[2]) ? card_slots.id[CardHash(name)] : -1;
+	return (id >= 0 && card_names[id][0] == name[0] && card_names[id][1] == name[1]) ? id : -1;
+}
+constexpr int PlaceIdOf(const char* name)
+{
+	int id = (name[0] && name[1] && !name[2]) ? place_slots.id[PlaceHash(name)] : -1;
+	return (id >= 0 && place_names[id][0] == name[0] && place_names[id][1] == name[1]) ? id : -1;
+}
 	
 class ClueReasoner
 {
 public:
-	ClueReasoner(){solver = new SatSolver();	player_num = -1;	AddInitialClauses();}
+	// 'config' gives the players and cards (the standard game by default); 'encoding' selects how
+	// the exactly-one and hand size constraints are turned into clauses.
+	ClueReasoner(CardinalityEncoding encoding = kTotalizer)		{Init(GameConfig(), encoding);}
+	ClueReasoner(const GameConfig& config, CardinalityEncoding encoding = kTotalizer)	{Init(config, encoding);}
 	~ClueReasoner(){delete solver;	solver = NULL;}
 	
+	const GameConfig& GetConfig() const	{return config;}
+	
 	// Convert from name to id.
 	int GetPlayerNum(std::string player);
 	int GetCardNum(std::string card);
 	
 	// Create the (positive) id for the literal that states 'player P has the card C'.
-	int GetPairNum(int player, int card);
+	int GetPairNum(int player, int card)	{return player * config.NumCards() + card + 1;}
 	int GetPairNum(std::string player, std::string card);
 		
 	int Query(std::string player, std::string card);
+	int Query(int player, int card);
 	std::string QueryString(int return_code);
 	void PrintNotepad();
+	void UpdateNotepad();	// what PrintNotepad does, short of printing
+	
+	// Sets probability[c][p] to the fraction of the deals consistent with everything known so far
+	// that put card c at place p, by counting models (see ModelCounter.h). Returns false if no
+	// deal is consistent.
+	bool GetProbabilities(std::vector<std::vector<double> >& probability);
+	void PrintProbabilities();
+	
+	// Sets solution[k] to the case file's card of category k (see GameConfig), or kNone while
+	// that is still open, and returns true if all of them are known. Only the case file column is
+	// checked, with one TestLiterals call for the cells the notepad has not decided yet.
+	bool GetSolution(int solution[num_categories]);
+	bool IsCaseFileSolved()	{int solution[num_categories];	return GetSolution(solution);}
 		
 	void AddInitialClauses();
 	void Hand(std::string player, std::string cards[3]);
 	void Suggest(std::string suggester, std::string card1, std::string card2, std::string card3, std::string refuter, std::string card_shown);
 	void Accuse(std::string suggester, std::string card1, std::string card2, std::string card3, bool is_correct);
 	
+	// Same as above, with place and card ids (see GameConfig; CardId and PlaceId for the standard
+	// game) instead of names. A hand has config.HandSize(player) cards.
+	void Hand(int player, const std::vector<int>& cards);
+	void Suggest(int suggester, int card1, int card2, int card3, int refuter, int card_shown);
+	void Accuse(int suggester, int card1, int card2, int card3, bool is_correct);
+	
+	// Replays a recorded game, one call per line:
+	//	hand sc wh li st			(player, the cards in their hand)
+	//	suggest mu pe pi di pe -		(suggester, three cards, refuter, card shown; "-" for none)
+	//	accuse pl pe pi ki 0		(suggester, three cards, 1 if correct)
+	// A card shown must be one of the three suggested, and needs a refuter; nothing may follow
+	// the last field. Blank lines and lines starting with '#' are skipped. The whole log is parsed before any
+	// clause is added, so a malformed line (reported on cout) leaves the reasoner untouched and
+	// returns false. Clause storage is reserved up front, and the solver runs once, at the end.
+	bool ReplayLog(std::istream& log);
+	
 private:
+	friend class SuggestAdvisor;
+	
+	void Init(const GameConfig& config, CardinalityEncoding encoding);
+	
+	// The rules of the game: exactly counts[i] of the literals in rules[i] are true. The solver
+	// gets them encoded as clauses (see Cardinality.h), the model counter as they are.
+	void GetRules(std::vector<Clause>& rules, std::vector<int>& counts);
+	
+	// Knowledge only grows, so a cell that is Y or n stays that way. 'notepad' keeps every
+	// answer found so far, and UpdateNotepad re-checks the open cells only if clauses were added
+	// since the last update (Hand, Suggest and Accuse set 'notepad_dirty').
+	void ClearNotepad();
+	
+	// Every card is in exactly one place, and the case file holds exactly one card of each
+	// category. Decide records that card 'card' is (value == kTrue) or is not (kFalse) at
+	// 'place' and follows these rules to every cell it settles, so those never reach the solver.
+	void Decide(int card, int place, int value);
+	void SetContradiction();
+	int& Cell(int card, int place)	{return notepad[card * config.NumPlaces() + place];}
+	
+	GameConfig config;
 	int player_num;	// Id of the current player (determined after Hand(..) is called).
 	SatSolver* solver;
+	CardinalityEncoding encoding;
+	int num_rule_clauses;	// the solver's first clauses, which encode the rules
+	std::vector<int> notepad;	// by card, then place (see Cell): kTrue, kFalse, kUnknown or kContradiction
+	bool notepad_dirty;
+	bool contradiction;
+	std::vector<Bitset> places;	// by card: the places it can still be at
+	Bitset case_file_cards[num_categories];	// by category: the cards, numbered within it, that can still be in the case file
 };
 
 #endif
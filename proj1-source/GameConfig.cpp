@@ -0,0 +1,97 @@
+#include "GameConfig.h"
+#include "ClueReasoner.h"
+using namespace std;
+
+bool Bitset::None() const
+{
+	for (size_t i = 0; i < words.size(); i++)
+		if (words[i])
+			return false;
+	return true;
+}
+
+int Bitset::Single() const
+{
+	int found = -1;
+	for (size_t i = 0; i < words.size(); i++)
+	{
+		if (!words[i])
+			continue;
+		if (found >= 0 || (words[i] & (words[i] - 1)) != 0)
+			return -1;
+		found = 64 * i + __builtin_ctzll(words[i]);
+	}
+	return found;
+}
+
+GameConfig::GameConfig()
+{
+	// ::num_players is the standard game's, not the member.
+	vector<string> categories[num_categories] = {
+		vector<string>(suspects, suspects + num_suspects),
+		vector<string>(weapons, weapons + num_weapons),
+		vector<string>(rooms, rooms + num_rooms)};
+	Init(vector<string>(players, players + ::num_players), categories);
+	standard = true;
+}
+
+GameConfig::GameConfig(const vector<string>& players, const vector<string>& suspects, const vector<string>& weapons, const vector<string>& rooms)
+{
+	vector<string> categories[num_categories] = {suspects, weapons, rooms};
+	Init(players, categories);
+}
+
+GameConfig GameConfig::Generated(int num_players, int num_suspects, int num_weapons, int num_rooms)
+{
+	vector<string> names[num_categories + 1];
+	int sizes[num_categories + 1] = {num_players, num_suspects, num_weapons, num_rooms};
+	const char prefixes[num_categories + 1] = {'p', 's', 'w', 'r'};
+	for (int k = 0; k <= num_categories; k++)
+		for (int i = 0; i < sizes[k]; i++)
+			names[k].push_back(prefixes[k] + to_string(i));
+	return GameConfig(names[0], names[1], names[2], names[3]);
+}
+
+void GameConfig::Init(const vector<string>& players, const vector<string>* categories)
+{
+	standard = false;
+	num_players = players.size();
+	place_names = players;
+	place_names.push_back(case_file);
+	for (size_t p = 0; p < place_names.size(); p++)
+		place_ids[place_names[p]] = p;
+	
+	for (int k = 0; k < num_categories; k++)
+	{
+		category_first[k] = card_names.size();
+		for (size_t i = 0; i < categories[k].size(); i++)
+		{
+			card_ids[categories[k][i]] = card_names.size();
+			card_names.push_back(categories[k][i]);
+			card_category.push_back(k);
+		}
+	}
+	category_first[num_categories] = card_names.size();
+}
+
+int GameConfig::HandSize(int player) const
+{
+	int dealt = NumCards() - num_categories;
+	return dealt / num_players + (player < dealt % num_players);
+}
+
+int GameConfig::PlaceId(const string& name) const
+{
+	if (standard)
+		return PlaceIdOf(name.c_str());
+	map<string, int>::const_iterator found = place_ids.find(name);
+	return (found != place_ids.end()) ? found->second : -1;
+}
+
+int GameConfig::CardId(const string& name) const
+{
+	if (standard)
+		return CardIdOf(name.c_str());
+	map<string, int>::const_iterator found = card_ids.find(name);
+	return (found != card_ids.end()) ? found->second : -1;
+}
@@ -0,0 +1,72 @@
+#ifndef GAME_CONFIG_H
+#define GAME_CONFIG_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+// Every game has suspects, weapons and rooms, and a suggestion or accusation names one of each.
+const int num_categories = 3;
+
+// A fixed-size set of small integers (places or cards), one bit each, packed into 64-bit words.
+class Bitset
+{
+public:
+	Bitset()	{}
+	Bitset(int size, bool value)	{words.assign((size + 63) / 64, 0);	if (value) for (int i = 0; i < size; i++) Set(i);}
+
+	void Set(int i)			{words[i / 64] |= uint64_t(1) << (i % 64);}
+	void Reset(int i)		{words[i / 64] &= ~(uint64_t(1) << (i % 64));}
+	bool Test(int i) const	{return words[i / 64] >> (i % 64) & 1;}
+	bool None() const;
+	int Single() const;		// the only element, or -1 if there are none or several
+
+private:
+	std::vector<uint64_t> words;
+};
+
+// The players and cards of a game. Places 0 .. NumPlayers() - 1 are the players' hands, in the
+// order they play, and place NumPlayers() is the case file. Cards are numbered category by
+// category, so category k is cards CategoryFirst(k) .. CategoryFirst(k) + CategorySize(k) - 1.
+// One card of each category goes to the case file and the rest are dealt around the table, the
+// first (NumCards() - num_categories) % NumPlayers() players getting one card more than the others.
+class GameConfig
+{
+public:
+	// The standard game, as laid out by the arrays in ClueReasoner.h.
+	GameConfig();
+	GameConfig(const std::vector<std::string>& players, const std::vector<std::string>& suspects,
+			   const std::vector<std::string>& weapons, const std::vector<std::string>& rooms);
+
+	// A game of the given size for stress testing, with players named p0, p1, ... and cards
+	// named s0, s1, ..., w0, ..., r0, ...
+	static GameConfig Generated(int num_players, int num_suspects, int num_weapons, int num_rooms);
+
+	int NumPlayers() const	{return num_players;}
+	int NumPlaces() const	{return num_players + 1;}
+	int NumCards() const	{return card_names.size();}
+	int CategoryFirst(int k) const	{return category_first[k];}
+	int CategorySize(int k) const	{return category_first[k + 1] - category_first[k];}
+	int CategoryOf(int card) const	{return card_category[card];}
+	int HandSize(int player) const;
+
+	const std::string& PlaceName(int place) const	{return place_names[place];}
+	const std::string& CardName(int card) const		{return card_names[card];}
+
+	// Name to id conversion; -1 if there is no such name.
+	int PlaceId(const std::string& name) const;
+	int CardId(const std::string& name) const;
+
+private:
+	void Init(const std::vector<std::string>& players, const std::vector<std::string>* categories);
+
+	int num_players;
+	std::vector<std::string> place_names;	// the players, then the case file
+	std::vector<std::string> card_names;
+	int category_first[num_categories + 1];
+	std::vector<int> card_category;
+	std::map<std::string, int> place_ids, card_ids;
+	bool standard;		// the standard names, which have a faster lookup (see CardIdOf)
+};
+#endif
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include "GameFarm.h"
+#include "ClueReasoner.h"
+using namespace std;
+
+// A worker's games. The owner takes games from the back; thieves take them from the front.
+struct GameQueue
+{
+	mutex lock;
+	deque<int> games;
+};
+
+static bool TakeGame(vector<GameQueue>& queues, int self, int& game)
+{
+	{
+		lock_guard<mutex> guard(queues[self].lock);
+		if (!queues[self].games.empty())
+		{
+			game = queues[self].games.back();
+			queues[self].games.pop_back();
+			return true;
+		}
+	}
+
+	for (size_t i = 1; i < queues.size(); i++)
+	{
+		GameQueue& victim = queues[(self + i) % queues.size()];
+		lock_guard<mutex> guard(victim.lock);
+		if (!victim.games.empty())
+		{
+			game = victim.games.front();
+			victim.games.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void GameFarm::PlayGame(int game, vector<double>& turn_us)
+{
+	mt19937 random(seed * 1000003u + game);
+
+	// Deal: one card of each category goes to the case file, the rest HandSize to each player.
+	vector<int> owner(config.NumCards(), config.NumPlayers());
+	vector<int> rest;
+	int case_file_cards[num_categories];
+	for (int k = 0; k < num_categories; k++)
+		case_file_cards[k] = config.CategoryFirst(k) + random() % config.CategorySize(k);
+	for (int c = 0; c < config.NumCards(); c++)
+		if (c != case_file_cards[config.CategoryOf(c)])
+			rest.push_back(c);
+	shuffle(rest.begin(), rest.end(), random);
+	for (int p = 0, i = 0; p < config.NumPlayers(); p++)
+		for (int j = 0; j < config.HandSize(p); j++)
+			owner[rest[i++]] = p;
+
+	ClueReasoner reasoner(config);
+	int me = game % config.NumPlayers();
+	vector<int> hand;
+	for (int c = 0; c < config.NumCards(); c++)
+		if (owner[c] == me)
+			hand.push_back(c);
+	reasoner.Hand(me, hand);
+
+	for (int turn = 0; turn < turns_per_game; turn++)
+	{
+		int suggester = turn % config.NumPlayers();
+		int suggested[num_categories];
+		for (int k = 0; k < num_categories; k++)
+			suggested[k] = config.CategoryFirst(k) + random() % config.CategorySize(k);
+
+		// The first player after the suggester holding a suggested card refutes; only the
+		// suggester sees which card is shown.
+		int refuter = kNone, card_shown = kNone;
+		for (int p = (suggester + 1) % config.NumPlayers(); p != suggester && refuter == kNone; p = (p + 1) % config.NumPlayers())
+			for (int k = 0; k < num_categories; k++)
+				if (owner[suggested[k]] == p)
+				{
+					refuter = p;
+					if (suggester == me)
+						card_shown = suggested[k];
+				}
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		reasoner.Suggest(suggester, suggested[0], suggested[1], suggested[2], refuter, card_shown);
+		reasoner.UpdateNotepad();
+		turn_us.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+	}
+}
+
+GameFarmStats GameFarm::Run(int num_games)
+{
+	int workers = max(1, num_threads);
+	vector<GameQueue> queues(workers);
+	for (int game = 0; game < num_games; game++)
+		queues[game % workers].games.push_back(game);
+
+	vector<vector<double> > turn_us(workers);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	vector<thread> threads;
+	for (int w = 0; w < workers; w++)
+		threads.push_back(thread([this, &queues, &turn_us, w]()
+		{
+			int game;
+			while (TakeGame(queues, w, game))
+				PlayGame(game, turn_us[w]);
+		}));
+	for (int w = 0; w < workers; w++)
+		threads[w].join();
+
+	GameFarmStats stats;
+	stats.games = num_games;
+	stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	stats.games_per_second = (stats.seconds > 0) ? num_games / stats.seconds : 0;
+
+	vector<double> all;
+	for (int w = 0; w < workers; w++)
+		all.insert(all.end(), turn_us[w].begin(), turn_us[w].end());
+	sort(all.begin(), all.end());
+	stats.turns = all.size();
+	stats.turn_p50_us = all.empty() ? 0 : all[(all.size() - 1) * 50 / 100];
+	stats.turn_p90_us = all.empty() ? 0 : all[(all.size() - 1) * 90 / 100];
+	stats.turn_p99_us = all.empty() ? 0 : all[(all.size() - 1) * 99 / 100];
+	stats.turn_max_us = all.empty() ? 0 : all.back();
+	return stats;
+}
+
+void GameFarm::PrintStats(const GameFarmStats& stats)
+{
+	cout<<stats.games<<" games, "<<stats.turns<<" turns in "<<stats.seconds<<" s ("<<stats.games_per_second<<" games/s)"<<endl;
+	cout<<"turn latency (us): p50 "<<stats.turn_p50_us<<"  p90 "<<stats.turn_p90_us<<"  p99 "<<stats.turn_p99_us<<"  max "<<stats.turn_max_us<<endl;
+}
@@ -0,0 +1,42 @@
+#ifndef GAME_FARM_H
+#define GAME_FARM_H
+
+#include <vector>
+#include "GameConfig.h"
+
+// Throughput and per-turn latency of a GameFarm run. A turn is one Suggest plus the notepad
+// update that follows it.
+struct GameFarmStats
+{
+	int games;
+	int turns;
+	double seconds;
+	double games_per_second;
+	double turn_p50_us, turn_p90_us, turn_p99_us, turn_max_us;
+};
+
+// Plays synthetic Clue games of the given configuration: each game deals the cards at random, gives one player's hand to a
+// fresh ClueReasoner, and feeds it 'turns_per_game' random suggestions with the refutations the
+// deal implies, updating the notepad after every turn. Games run on a pool of worker threads;
+// each worker owns a queue of games and steals from the others' queues once its own runs dry.
+// Every game has its own ClueReasoner, and so its own SatSolver and solver backends, and its own
+// random number generator seeded from 'seed' and the game number, so results do not depend on
+// the number of threads.
+class GameFarm
+{
+public:
+	GameFarm(int num_threads, int turns_per_game = 30, unsigned seed = 1, const GameConfig& config = GameConfig())
+		{this->num_threads = num_threads;	this->turns_per_game = turns_per_game;	this->seed = seed;	this->config = config;}
+
+	GameFarmStats Run(int num_games);
+	static void PrintStats(const GameFarmStats& stats);
+
+private:
+	void PlayGame(int game, std::vector<double>& turn_us);
+
+	int num_threads;
+	int turns_per_game;
+	unsigned seed;
+	GameConfig config;
+};
+#endif
@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <cmath>
+#include "ModelCounter.h"
+using namespace std;
+
+ModelCounter::ModelCounter(const ClauseArena& clauses, int num_vars)
+{
+	this->num_vars = num_vars;
+	occurrences.resize(num_vars + 1);
+	values.assign(num_vars + 1, 0);
+	rank.assign(num_vars + 1, num_vars + 1);
+	var_stamp.assign(num_vars + 1, 0);
+	slot.assign(num_vars + 1, 0);
+	stamp = 0;
+	cache_hits = cache_misses = 0;
+	constraint_start.push_back(0);
+	num_propagated = 0;
+
+	// Drop repeated literals and tautologies, so that counting true and false literals per clause
+	// tells exactly when a clause is satisfied, unit or falsified.
+	vector<Literal> lits;
+	for (int i = 0; i < clauses.NumClauses(); i++)
+	{
+		lits.assign(clauses.Begin(i), clauses.Begin(i) + clauses.Size(i));
+		sort(lits.begin(), lits.end());
+		lits.erase(unique(lits.begin(), lits.end()), lits.end());
+
+		bool tautology = false;
+		for (size_t j = 0; j < lits.size() && !tautology; j++)
+			tautology = binary_search(lits.begin(), lits.end(), -lits[j]);
+		if (!tautology)
+			AddConstraint(lits.data(), lits.size(), 1, lits.size());
+	}
+}
+
+void ModelCounter::AddConstraint(const Literal* lits, int num_lits, int at_least, int at_most)
+{
+	int c = num_true.size();
+	for (int j = 0; j < num_lits; j++)
+	{
+		Occurrence occurrence = {c, lits[j] > 0};
+		occurrences[abs(lits[j])].push_back(occurrence);
+	}
+	literals.insert(literals.end(), lits, lits + num_lits);
+	constraint_start.push_back(literals.size());
+	this->at_least.push_back(at_least);
+	this->at_most.push_back(at_most);
+	num_true.push_back(0);
+	num_false.push_back(0);
+	constraint_stamp.push_back(0);
+}
+
+void ModelCounter::SetDecisionOrder(const vector<int>& vars)
+{
+	for (int i = 0; i < (int) vars.size(); i++)
+		if (vars[i] >= 1 && vars[i] <= num_vars)
+			rank[vars[i]] = min(rank[vars[i]], i);
+}
+
+bool ModelCounter::Assign(Literal l)
+{
+	int v = abs(l);
+	if (values[v] != 0)
+		return (values[v] > 0) == (l > 0);
+	values[v] = (l > 0 ? 1 : -1);
+	trail.push_back(v);
+	return true;
+}
+
+bool ModelCounter::Propagate()
+{
+	// Every occurrence of a variable is counted, even after a conflict, so Undo can count them back.
+	bool conflict = false;
+	while (num_propagated < (int) trail.size())
+	{
+		int v = trail[num_propagated++];
+		for (size_t k = 0; k < occurrences[v].size(); k++)
+		{
+			int c = occurrences[v][k].constraint;
+			if (occurrences[v][k].positive == (values[v] > 0))
+			{
+				// At most 'at_most' true: once that many are, the rest are false.
+				num_true[c]++;
+				if (num_true[c] > at_most[c])
+					conflict = true;
+				else if (num_true[c] == at_most[c] && !conflict)
+					Force(c, false);
+			}
+			else
+			{
+				// At least 'at_least' true: once only that many can be, they all are.
+				num_false[c]++;
+				if (num_false[c] > Size(c) - at_least[c])
+					conflict = true;
+				else if (num_false[c] == Size(c) - at_least[c] && !conflict)
+					Force(c, true);
+			}
+		}
+		if (conflict)
+			return false;
+	}
+	return true;
+}
+
+void ModelCounter::Force(int c, bool value)
+{
+	// The counts lag behind assignments still waiting in the trail, so only the unassigned literals
+	// are set; one already set the other way pushes a count past its bound once it is propagated.
+	for (int j = constraint_start[c]; j < constraint_start[c + 1]; j++)
+		if (values[abs(literals[j])] == 0)
+			Assign(value ? literals[j] : -literals[j]);
+}
+
+void ModelCounter::Undo(int trail_size)
+{
+	while ((int) trail.size() > trail_size)
+	{
+		int v = trail.back();
+		if ((int) trail.size() <= num_propagated)
+			for (size_t k = 0; k < occurrences[v].size(); k++)
+			{
+				if (occurrences[v][k].positive == (values[v] > 0))
+					num_true[occurrences[v][k].constraint]--;
+				else
+					num_false[occurrences[v][k].constraint]--;
+			}
+		values[v] = 0;
+		trail.pop_back();
+	}
+	num_propagated = min<int>(num_propagated, trail.size());
+}
+
+void ModelCounter::FindComponents(const vector<int>& scope, vector<vector<int> >& components, vector<Fingerprint>& keys, vector<int>& free_vars)
+{
+	// Walks from each unassigned variable through the constraints that are not yet satisfied. A
+	// component's key sums the fingerprints of those constraints' unassigned literals, under the
+	// bounds that are left for them.
+	stamp++;
+	vector<Literal> residual;
+	for (size_t i = 0; i < scope.size(); i++)
+	{
+		int start = scope[i];
+		if (values[start] != 0 || var_stamp[start] == stamp)
+			continue;
+
+		vector<int> component(1, start);
+		var_stamp[start] = stamp;
+		Fingerprint key;
+		bool has_constraint = false;
+		for (size_t next = 0; next < component.size(); next++)
+		{
+			int v = component[next];
+			for (size_t k = 0; k < occurrences[v].size(); k++)
+			{
+				int c = occurrences[v][k].constraint;
+				if (IsSatisfied(c) || constraint_stamp[c] == stamp)
+					continue;
+				constraint_stamp[c] = stamp;
+				has_constraint = true;
+
+				residual.clear();
+				for (int j = constraint_start[c]; j < constraint_start[c + 1]; j++)
+				{
+					int u = abs(literals[j]);
+					if (values[u] != 0)
+						continue;
+					residual.push_back(literals[j]);
+					if (var_stamp[u] != stamp)
+					{
+						var_stamp[u] = stamp;
+						component.push_back(u);
+					}
+				}
+				int open = residual.size();
+				key = key + Fingerprint::OfConstraint(residual.data(), open, max(at_least[c] - num_true[c], 0), min(at_most[c] - num_true[c], open));
+			}
+		}
+
+		if (!has_constraint)
+			free_vars.push_back(start);
+		else
+		{
+			sort(component.begin(), component.end());
+			components.push_back(component);
+			keys.push_back(key);
+		}
+	}
+}
+
+double ModelCounter::CountScope(const vector<int>& scope, vector<double>& true_counts)
+{
+	// Counts the assignments of the variables in 'scope' that extend the current assignment to a
+	// model (every constraint touching an unassigned variable of the scope lies within the scope), and
+	// sets true_counts[i] to the number of those with scope[i] true.
+	vector<vector<int> > components;
+	vector<Fingerprint> keys;
+	vector<int> free_vars;
+	FindComponents(scope, components, keys, free_vars);
+
+	true_counts.assign(scope.size(), 0);
+	double count = ldexp(1.0, free_vars.size());
+	vector<double> component_counts(components.size());
+	vector<vector<double> > component_true_counts(components.size());
+	for (size_t i = 0; i < components.size(); i++)
+	{
+		component_counts[i] = CountComponent(components[i], keys[i], component_true_counts[i]);
+		if (component_counts[i] == 0)
+			return 0;
+		count *= component_counts[i];
+	}
+
+	for (size_t i = 0; i < scope.size(); i++)
+	{
+		slot[scope[i]] = i;
+		if (values[scope[i]] != 0)
+			true_counts[i] = (values[scope[i]] > 0) ? count : 0;
+	}
+	for (size_t i = 0; i < free_vars.size(); i++)
+		true_counts[slot[free_vars[i]]] = count / 2;
+	for (size_t i = 0; i < components.size(); i++)
+	{
+		double others = count / component_counts[i];
+		for (size_t j = 0; j < components[i].size(); j++)
+			true_counts[slot[components[i][j]]] = component_true_counts[i][j] * others;
+	}
+	return count;
+}
+
+double ModelCounter::CountComponent(const vector<int>& vars, const Fingerprint& key, vector<double>& true_counts)
+{
+	map<Fingerprint, CachedComponent>::iterator cached = cache.find(key);
+	if (cached != cache.end())
+	{
+		cache_hits++;
+		true_counts = cached->second.true_counts;
+		return cached->second.count;
+	}
+	cache_misses++;
+
+	// Decide on the variable first in the decision order, or failing that the one in most constraints.
+	int decision = vars[0];
+	for (size_t i = 1; i < vars.size(); i++)
+	{
+		int v = vars[i];
+		if (rank[v] < rank[decision] || (rank[v] == rank[decision] && occurrences[v].size() > occurrences[decision].size()))
+			decision = v;
+	}
+
+	double count = 0;
+	true_counts.assign(vars.size(), 0);
+	vector<double> branch_true_counts;
+	for (int sign = 1; sign >= -1; sign -= 2)
+	{
+		int trail_size = trail.size();
+		if (Assign(sign * decision) && Propagate())
+		{
+			count += CountScope(vars, branch_true_counts);
+			for (size_t i = 0; i < branch_true_counts.size(); i++)
+				true_counts[i] += branch_true_counts[i];
+		}
+		Undo(trail_size);
+	}
+
+	if (cache.size() >= kComponentCacheSize)
+		cache.clear();
+	CachedComponent& entry = cache[key];
+	entry.count = count;
+	entry.true_counts = true_counts;
+	return count;
+}
+
+double ModelCounter::Count(vector<double>* true_counts)
+{
+	Undo(0);
+	if (true_counts)
+		true_counts->assign(num_vars + 1, 0);
+
+	// Constraints that can only hold one way first (unit clauses, for one), then everything else
+	// is one scope. An empty clause cannot hold at all.
+	bool consistent = true;
+	for (size_t c = 0; c < at_least.size() && consistent; c++)
+	{
+		consistent = (at_least[c] <= at_most[c] && at_least[c] <= Size(c) && at_most[c] >= 0);
+		if (at_least[c] == Size(c))
+			Force(c, true);
+		else if (at_most[c] == 0)
+			Force(c, false);
+	}
+	if (!consistent || !Propagate())
+	{
+		Undo(0);
+		return 0;
+	}
+
+	vector<int> scope;
+	for (int v = 1; v <= num_vars; v++)
+		scope.push_back(v);
+	vector<double> scope_true_counts;
+	double count = CountScope(scope, scope_true_counts);
+	Undo(0);
+
+	if (true_counts)
+		for (int v = 1; v <= num_vars; v++)
+			(*true_counts)[v] = scope_true_counts[v - 1];
+	return count;
+}
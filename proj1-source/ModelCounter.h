@@ -0,0 +1,88 @@
+#ifndef MODEL_COUNTER_H
+#define MODEL_COUNTER_H
+
+#include <vector>
+#include <map>
+#include "SatSolver.h"
+
+// Number of components ModelCounter remembers before it starts over with an empty cache.
+const int kComponentCacheSize = 1 << 18;
+
+// Counts the models of a clause set over variables 1..num_vars (#SAT), together with the number
+// of models in which each variable is true, in one search. Besides clauses, it takes cardinality
+// constraints ("exactly k of these literals") as they are, without auxiliary variables.
+//
+// The search is DPLL with propagation: a clause or constraint that can only hold one way forces its
+// open literals. After each decision the unassigned variables split into connected components
+// (variables sharing a constraint that may still fail), which are counted separately and
+// multiplied. Each component is cached under a fingerprint of its remaining constraints, so a
+// sub-formula that the search reaches along different paths, e.g. after dealing the same number
+// of cards to each player in a different order, is counted only once. Counts are doubles, which
+// are exact up to 2^53.
+class ModelCounter
+{
+public:
+	ModelCounter(const ClauseArena& clauses, int num_vars);
+
+	// Variables to decide on first, in this order (the rest go by number of occurrences). Variables
+	// that are decided in a consistent order make the remaining formulas coincide more often.
+	void SetDecisionOrder(const std::vector<int>& vars);
+
+	// Adds the constraint that exactly k of 'lits', which are over distinct variables, are true.
+	void AddExactly(const std::vector<Literal>& lits, int k)	{AddConstraint(lits.data(), lits.size(), k, k);}
+
+	// Returns the number of models; true_counts, if given, receives (indexed by variable) the number
+	// of models with the variable true.
+	double Count(std::vector<double>* true_counts);
+
+	long GetCacheHits() const	{return cache_hits;}
+	long GetCacheMisses() const	{return cache_misses;}
+
+private:
+	struct Occurrence
+	{
+		int constraint;
+		bool positive;
+	};
+	struct CachedComponent
+	{
+		double count;
+		std::vector<double> true_counts;	// by position in the component's sorted variables
+	};
+
+	// A clause is the constraint that at least one of its literals is true.
+	void AddConstraint(const Literal* lits, int num_lits, int at_least, int at_most);
+	int Size(int c) const	{return constraint_start[c + 1] - constraint_start[c];}
+	bool IsSatisfied(int c) const	{return num_true[c] >= at_least[c] && num_false[c] >= Size(c) - at_most[c];}
+
+	bool Assign(Literal l);
+	bool Propagate();
+	void Force(int c, bool value);
+	void Undo(int trail_size);
+
+	// CountScope splits the unassigned variables of 'scope' into components and free variables;
+	// CountComponent decides on one variable of a component and counts both branches.
+	double CountScope(const std::vector<int>& scope, std::vector<double>& true_counts);
+	double CountComponent(const std::vector<int>& vars, const Fingerprint& key, std::vector<double>& true_counts);
+	void FindComponents(const std::vector<int>& scope, std::vector<std::vector<int> >& components, std::vector<Fingerprint>& keys, std::vector<int>& free_vars);
+
+	int num_vars;
+	std::vector<Literal> literals;			// constraints back to back; clauses without repeated literals or tautologies
+	std::vector<int> constraint_start;		// constraint i is literals[constraint_start[i] .. constraint_start[i + 1])
+	std::vector<int> at_least, at_most;		// by constraint: how many of its literals may be true
+	std::vector<std::vector<Occurrence> > occurrences;	// by variable
+	std::vector<int> num_true, num_false;	// by constraint, over the propagated part of the trail
+
+	std::vector<signed char> values;		// by variable: 1, -1 or 0
+	std::vector<int> trail;					// assigned variables, in order
+	int num_propagated;
+
+	std::vector<int> rank;					// by variable: position in the decision order, or num_vars + 1
+	std::vector<int> var_stamp, constraint_stamp;	// visit marks for FindComponents
+	int stamp;
+	std::vector<int> slot;					// scratch: a variable's position in the scope being combined
+
+	std::map<Fingerprint, CachedComponent> cache;
+	long cache_hits, cache_misses;
+};
+#endif
@@ -1,78 +1,349 @@
 #include <cstdlib>
+#include <algorithm>
+#include <thread>
+#include <atomic>
 #include "SatSolver.h"
+#include "SolverBackend.h"
 using namespace std;
 
-bool SatSolver::MakeQuery()
+SatSolver::SatSolver()
+{
+	backend_choice = kAutoBackend;
+	for (int i = 0; i <= kExternalBackend; i++)
+		backends[i] = NULL;
+	cache_hits = cache_misses = 0;
+}
+
+SatSolver::SatSolver(const SatSolver& other)
+{
+	clauses = other.clauses;
+	model_cache = other.model_cache;
+	result_cache = other.result_cache;
+	propagator = other.propagator;
+	frames = other.frames;
+	backend_choice = other.backend_choice;
+	for (int i = 0; i <= kExternalBackend; i++)
+		backends[i] = NULL;
+	cache_hits = cache_misses = 0;
+}
+
+SatSolver::~SatSolver()
+{
+	for (int i = 0; i <= kExternalBackend; i++)
+		delete backends[i];
+}
+
+static uint64_t Mix64(uint64_t x)
+{
+	// splitmix64 finalizer
+	x ^= x >> 30;	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;	x *= 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+Fingerprint Fingerprint::OfClause(const Literal* lits, int num_lits)
+{
+	// The two halves use independently seeded hashes, so a collision needs both to collide.
+	Fingerprint f;
+	for (int i = 0; i < num_lits; i++)
+	{
+		uint64_t l = (uint32_t) lits[i];
+		f.lo += Mix64(l + 0x9e3779b97f4a7c15ULL);
+		f.hi += Mix64(l ^ 0xc2b2ae3d27d4eb4fULL);
+	}
+	f.lo = Mix64(f.lo ^ num_lits);
+	f.hi = Mix64(f.hi + num_lits);
+	return f;
+}
+
+Fingerprint Fingerprint::OfConstraint(const Literal* lits, int num_lits, int at_least, int at_most)
+{
+	Fingerprint f = OfClause(lits, num_lits);
+	if (at_least == 1 && at_most == num_lits)
+		return f;
+	uint64_t bounds = ((uint64_t) (uint32_t) at_least << 32) | (uint32_t) at_most;
+	f.lo = Mix64(f.lo ^ Mix64(bounds));
+	f.hi = Mix64(f.hi + bounds);
+	return f;
+}
+
+void ClauseArena::Add(const Literal* lits, int num_lits)
+{
+	literals.insert(literals.end(), lits, lits + num_lits);
+	offsets.push_back(literals.size());
+	for (int i = 0; i < num_lits; i++)
+		max_var = max(max_var, abs(lits[i]));
+	fingerprint = fingerprint + Fingerprint::OfClause(lits, num_lits);
+}
+
+void UnitPropagator::Assign(Literal l)
 {
-	// Create a vector that contains all the elements in 'clauses' and 'query_clauses'.
-	vector<Clause> all_clauses = clauses;
-	all_clauses.insert(all_clauses.end(), query_clauses.begin(), query_clauses.end());
+	values[abs(l)] = (l > 0 ? 1 : -1);
+	trail.push_back(l);
+}
+
+void UnitPropagator::Sync(const ClauseArena& clauses)
+{
+	if (inconsistent || num_synced == clauses.NumClauses())
+		return;
 	
-	// Find the literal with the largest absolute value. 
-	int max_var = 0;
-	for (int i = 0; i < all_clauses.size(); i++)
-		for (int j = 0; j < all_clauses[i].size(); j++)
-			if (abs(all_clauses[i][j]) > max_var)
-				max_var = abs(all_clauses[i][j]);
+	values.resize(clauses.MaxVar() + 1, 0);
+	watches.resize(2 * (clauses.MaxVar() + 1));
+	watched.resize(2 * clauses.NumClauses(), -1);
+	
+	for (; num_synced < clauses.NumClauses() && !inconsistent; num_synced++)
+	{
+		// Watch two distinct literals that are not false. A clause that is already true stays
+		// true, so it needs no watches; one with a single candidate left is a unit.
+		int c = num_synced;
+		const Literal* lits = clauses.Begin(c);
+		int first = -1, second = -1;
+		bool satisfied = false;
+		for (int i = 0; i < clauses.Size(c) && !satisfied && second < 0; i++)
+		{
+			if (Value(lits[i]) > 0)
+				satisfied = true;
+			else if (Value(lits[i]) == 0 && first < 0)
+				first = i;
+			else if (Value(lits[i]) == 0 && lits[i] != lits[first])
+				second = i;
+		}
+		
+		if (satisfied)
+			continue;
+		if (first < 0)
+			inconsistent = true;
+		else if (second < 0)
+			Assign(lits[first]);
+		else
+		{
+			watched[2 * c] = first;
+			watched[2 * c + 1] = second;
+			watches[Index(lits[first])].push_back(c);
+			watches[Index(lits[second])].push_back(c);
+		}
+		Propagate(clauses);
+	}
+}
+
+void UnitPropagator::Propagate(const ClauseArena& clauses)
+{
+	for (; num_propagated < (int) trail.size() && !inconsistent; num_propagated++)
+	{
+		// Visit the clauses watching the literal that just became false.
+		Literal falsified = -trail[num_propagated];
+		vector<int>& list = watches[Index(falsified)];
+		for (size_t k = 0; k < list.size() && !inconsistent; )
+		{
+			int c = list[k];
+			const Literal* lits = clauses.Begin(c);
+			int slot = (lits[watched[2 * c]] == falsified) ? 0 : 1;
+			Literal other = lits[watched[2 * c + 1 - slot]];
+			if (Value(other) > 0)
+			{
+				k++;
+				continue;
+			}
+			
+			int replacement = -1;
+			for (int i = 0; i < clauses.Size(c) && replacement < 0; i++)
+				if (Value(lits[i]) >= 0 && lits[i] != falsified && lits[i] != other)
+					replacement = i;
+			
+			if (replacement >= 0)
+			{
+				watched[2 * c + slot] = replacement;
+				watches[Index(lits[replacement])].push_back(c);
+				list[k] = list.back();
+				list.pop_back();
+			}
+			else
+			{
+				if (Value(other) < 0)
+					inconsistent = true;
+				else
+					Assign(other);
+				k++;
+			}
+		}
+	}
+}
 
-	// Print out the CNF query file.
-	ofstream dimacs;
-	dimacs.open("query.cnf");
-	dimacs<<"c This DIMACS format CNF file was generated by SatSolver.cpp"<<endl;
-	dimacs<<"c Do not edit."<<endl;
+void UnitPropagator::Rewind(const Mark& mark, const ClauseArena& clauses)
+{
+	for (int c = mark.num_synced; c < num_synced; c++)
+		for (int slot = 0; slot < 2; slot++)
+			if (watched[2 * c + slot] >= 0)
+			{
+				vector<int>& list = watches[Index(clauses.Begin(c)[watched[2 * c + slot]])];
+				list.erase(find(list.begin(), list.end(), c));
+			}
+	watched.resize(2 * mark.num_synced);
 	
-	dimacs<<"p cnf "<<max_var<<" "<<all_clauses.size()<<endl;
+	for (int i = mark.trail_size; i < (int) trail.size(); i++)
+		values[abs(trail[i])] = 0;
+	trail.resize(mark.trail_size);
+	num_propagated = mark.num_propagated;
+	num_synced = mark.num_synced;
+	inconsistent = mark.inconsistent;
+}
+
+void SatSolver::AddClause(const Literal* lits, int num_lits)
+{
+	clauses.Add(lits, num_lits);
 	
-	for (int i = 0; i < all_clauses.size(); i++)
+	// Keep only the cached models that the new clause holds in.
+	for (int i = model_cache.size() - 1; i >= 0; i--)
 	{
-		for (int j = 0; j < all_clauses[i].size(); j++)
-			dimacs<<all_clauses[i][j]<<" ";
+		bool satisfied = false;
+		for (int j = 0; j < num_lits && !satisfied; j++)
+			satisfied = (ModelValue(model_cache[i], abs(lits[j])) == (lits[j] > 0));
 		
-		dimacs<<"0"<<endl;
-	}
-	dimacs.close();
-	
-	// Call zChaff with the query file and read its result.
-	FILE* pipe = popen("./zchaff query.cnf", "r");
-    if (!pipe) return "ERROR";
-    char buffer[128];
-    string result = "";
-    while(!feof(pipe)) {
-    	if(fgets(buffer, 128, pipe) != NULL)
-    		result += buffer;
-    }
-    pclose(pipe);
-    	
-	int found = result.find("RESULT:\tSAT");
-	if (found != string::npos)
-		return true;
+		if (!satisfied)
+			model_cache.erase(model_cache.begin() + i);
+	}
+}
+
+void SatSolver::ClearClauses()
+{
+	clauses.Clear();
+	model_cache.clear();
+	propagator.Clear();
+	frames.clear();
+	for (int i = 0; i <= kExternalBackend; i++)
+		if (backends[i])
+			backends[i]->Reset();
+}
+
+void SatSolver::Push()
+{
+	// Syncing first makes the propagator's mark line up with the arena's.
+	propagator.Sync(clauses);
+	Frame frame;
+	frame.clauses = clauses.GetMark();
+	frame.propagator = propagator.GetMark();
+	frame.model_cache = model_cache;
+	frames.push_back(frame);
 	
-	return false;
+	for (int i = 0; i <= kExternalBackend; i++)
+		if (backends[i])
+			backends[i]->Push(frame.clauses.num_clauses);
+}
+
+void SatSolver::Pop()
+{
+	if (frames.empty())
+		return;
+	Frame& frame = frames.back();
+	propagator.Rewind(frame.propagator, clauses);
+	clauses.Rewind(frame.clauses);
+	for (int i = 0; i <= kExternalBackend; i++)
+		if (backends[i])
+			backends[i]->Pop();
+	
+	// Keep the newest models, from inside the frame, over the older ones.
+	vector<ModelBits> models = frame.model_cache;
+	models.insert(models.end(), model_cache.begin(), model_cache.end());
+	if (models.size() > kModelCacheSize)
+		models.erase(models.begin(), models.end() - kModelCacheSize);
+	model_cache.swap(models);
+	frames.pop_back();
+}
+
+int SatSolver::PropagatedValue(Literal l)
+{
+	propagator.Sync(clauses);
+	return propagator.IsInconsistent() ? kContradiction : propagator.Value(l);
+}
+
+SolverBackend* SatSolver::PickBackend()
+{
+	BackendChoice choice = backend_choice;
+	if (choice == kAutoBackend)
+		choice = (clauses.NumLiterals() + query_clauses.NumLiterals() <= kDpllMaxLiterals) ? kDpllBackend : kZchaffBackend;
+	
+	if (!backends[choice])
+	{
+		if (choice == kDpllBackend)
+			backends[choice] = new DpllBackend();
+		else if (choice == kZchaffBackend)
+			backends[choice] = new ZchaffBackend();
+		else
+			backends[choice] = new ExternalBackend();
+		
+		// A backend made inside what-if frames learns about them as if it had been there all along.
+		for (size_t i = 0; i < frames.size(); i++)
+			backends[choice]->Push(frames[i].clauses.num_clauses);
+	}
+	return backends[choice];
+}
+
+bool SatSolver::MakeQuery()
+{
+	return MakeQuery(NULL);
+}
+
+bool SatSolver::MakeQuery(vector<int>* model)
+{
+	if (model)
+		model->clear();
+	
+	// The key covers the whole clause set, so entries stay valid across ClearClauses. A hit
+	// leaves 'model' empty, which callers already handle (see RecordModel).
+	Fingerprint key = clauses.GetFingerprint() + query_clauses.GetFingerprint();
+	map<Fingerprint, bool>::iterator cached = result_cache.find(key);
+	if (cached != result_cache.end())
+	{
+		cache_hits++;
+		return cached->second;
+	}
+	cache_misses++;
+	
+	bool sat = PickBackend()->Solve(clauses, query_clauses, model);
+	if (result_cache.size() >= kResultCacheSize)
+		result_cache.clear();
+	result_cache[key] = sat;
+	return sat;
 }
 
 int SatSolver::TestLiteral(Literal l)
 {
 	// Calls the SAT solver twice, once with l, once with -l and determines whether l is true (1), false (-1), or can take both values (0).
 	
+	// A cached model that already has l false (true) answers the first (second) half without a solver call.
+	
 	l = abs(l);
 	bool l_pos, l_neg;
+	vector<int> model;
+	
+	propagator.Sync(clauses);
+	if (propagator.IsInconsistent())
+		return kContradiction;
+	if (propagator.Value(l) != 0)
+		return HasModel() ? propagator.Value(l) : kContradiction;
 	
 	// Try to show that l holds
+	if (IsCachedModelWith(-l))
+		l_pos = false;
+	else
 	{	
 		ClearQueryClauses();
-		Clause c;
-		c.push_back(-l);	// Add negation
-		AddQueryClause(c);
-		l_pos = !MakeQuery();	// If query returns UNSAT, means l is entailed
+		AddQueryClause({-l});	// Add negation
+		l_pos = !MakeQuery(&model);	// If query returns UNSAT, means l is entailed
+		if (!l_pos)
+			CacheModel(model);
 	}
 	
 	// Try to show that -l holds
+	if (IsCachedModelWith(l))
+		l_neg = false;
+	else
 	{
 		ClearQueryClauses();
-		Clause c;
-		c.push_back(l);	// Add negation
-		AddQueryClause(c);
-		l_neg = !MakeQuery();	// If query returns UNSAT, means -l is entailed
+		AddQueryClause({l});	// Add negation
+		l_neg = !MakeQuery(&model);	// If query returns UNSAT, means -l is entailed
+		if (!l_neg)
+			CacheModel(model);
 	}	
 	ClearQueryClauses();
 
@@ -85,3 +356,235 @@ int SatSolver::TestLiteral(Literal l)
 	else
 		return kUnknown;
 }
+
+vector<int> SatSolver::TestLiterals(const vector<Literal>& literals)
+{
+	int max_var = 0;
+	for (size_t i = 0; i < literals.size(); i++)
+		max_var = max(max_var, abs(literals[i]));
+	
+	// can_be_true[v] (can_be_false[v]) is set once some model with v true (false) has been seen.
+	vector<bool> can_be_true(max_var + 1, false), can_be_false(max_var + 1, false);
+	vector<int> model;
+	
+	// Start from the cached models; only if there are none does the clause set need a first solve.
+	for (size_t i = 0; i < model_cache.size(); i++)
+		for (int v = 1; v <= max_var; v++)
+			(ModelValue(model_cache[i], v) ? can_be_true : can_be_false)[v] = true;
+	
+	propagator.Sync(clauses);
+	if (propagator.IsInconsistent())
+		return vector<int>(literals.size(), kContradiction);
+	
+	ClearQueryClauses();
+	if (model_cache.empty())
+	{
+		if (!MakeQuery(&model))
+			return vector<int>(literals.size(), kContradiction);
+		if (RecordModel(model, can_be_true, can_be_false))
+			CacheModel(model);
+	}
+	
+	// A literal implied by unit propagation holds in every model, and a model exists.
+	for (size_t i = 0; i < literals.size(); i++)
+	{
+		Literal l = abs(literals[i]);
+		if (propagator.Value(l) != 0)
+			(propagator.Value(l) > 0 ? can_be_true : can_be_false)[l] = true;
+	}
+	
+	// The polarities that no model has shown yet are asked for several at a time: they are split
+	// into up to kWitnessGroups runs, each run one query clause, so a model shows at least one
+	// new polarity per run. If no model has them all, the runs are merged (halving their number)
+	// down to one clause holding every pending polarity; if even that is UNSAT, none of them is
+	// possible, and their opposites are entailed. Those are also handed to the backends as
+	// permanent units, which is sound and saves later queries from re-deriving them. A SAT answer
+	// without a model (see RecordModel) shows nothing in particular, so from then on polarities
+	// are asked one at a time.
+	vector<bool> ruled_out(2 * (max_var + 1), false);	// by 2 * var + (polarity is false)
+	vector<Literal> pending;
+	int num_groups = kWitnessGroups;
+	bool one_at_a_time = false;
+	while (true)
+	{
+		pending.clear();
+		for (size_t i = 0; i < literals.size(); i++)
+		{
+			Literal l = abs(literals[i]);
+			if (propagator.Value(l) != 0)
+				continue;
+			if (!can_be_true[l] && !ruled_out[2 * l])
+				pending.push_back(l);
+			if (!can_be_false[l] && !ruled_out[2 * l + 1])
+				pending.push_back(-l);
+		}
+		if (pending.empty())
+			break;
+		
+		if (one_at_a_time)
+			pending.resize(1);
+		num_groups = min<int>(num_groups, pending.size());
+		ClearQueryClauses();
+		for (int g = 0; g < num_groups; g++)
+		{
+			int begin = g * pending.size() / num_groups, end = (g + 1) * pending.size() / num_groups;
+			AddQueryClause(pending.data() + begin, end - begin);
+		}
+		
+		if (MakeQuery(&model))
+		{
+			bool recorded = RecordModel(model, can_be_true, can_be_false);
+			if (pending.size() == 1)
+				(pending[0] > 0 ? can_be_true : can_be_false)[abs(pending[0])] = true;
+			else if (!recorded)
+				one_at_a_time = true;
+			if (recorded)
+				CacheModel(model);
+		}
+		else if (num_groups > 1)
+			num_groups /= 2;
+		else
+			for (size_t i = 0; i < pending.size(); i++)
+			{
+				ruled_out[2 * abs(pending[i]) + (pending[i] < 0)] = true;
+				Literal entailed = -pending[i];
+				for (int b = 0; b <= kExternalBackend; b++)
+					if (backends[b])
+						backends[b]->AddEntailedClause(&entailed, 1);
+			}
+	}
+	ClearQueryClauses();
+	
+	vector<int> results(literals.size());
+	for (size_t i = 0; i < literals.size(); i++)
+	{
+		Literal l = abs(literals[i]);
+		if (can_be_true[l] && can_be_false[l])
+			results[i] = kUnknown;
+		else if (can_be_true[l])
+			results[i] = kTrue;
+		else
+			results[i] = kFalse;
+	}
+	return results;
+}
+
+bool SatSolver::RecordModel(const vector<int>& model, vector<bool>& can_be_true, vector<bool>& can_be_false)
+{
+	// An empty model means the solver did not report one (the external solver). Otherwise,
+	// variables missing from the model (not mentioned by any clause) or left unassigned are free,
+	// so both of their values are possible. Any other value means the backend is broken, and the
+	// model shows nothing; returns false if nothing was recorded.
+	if (model.empty())
+		return false;
+	if (!IsWellFormed(model))
+	{
+		cerr<<"SatSolver: the solver reported a model with a value other than 1, 0 or -1"<<endl;
+		return false;
+	}
+	
+	for (size_t v = 1; v < can_be_true.size(); v++)
+	{
+		int value = v < model.size() ? model[v] : -1;
+		if (value != 0)
+			can_be_true[v] = true;
+		if (value != 1)
+			can_be_false[v] = true;
+	}
+	return true;
+}
+
+bool SatSolver::IsWellFormed(const vector<int>& model)
+{
+	for (size_t v = 1; v < model.size(); v++)
+		if (model[v] != 1 && model[v] != 0 && model[v] != -1)
+			return false;
+	return true;
+}
+
+bool SatSolver::ModelValue(const ModelBits& bits, int var)
+{
+	size_t word = var / 32;
+	return word < bits.size() && (bits[word] >> (var % 32) & 1);
+}
+
+void SatSolver::CacheModel(const vector<int>& model)
+{
+	// Models the solver did not report or got wrong (see RecordModel) cannot be cached.
+	if (model.empty() || !IsWellFormed(model))
+		return;
+	
+	// Unassigned variables are in no clause, so storing them as false keeps the model valid.
+	ModelBits bits(model.size() / 32 + 1, 0);
+	for (size_t v = 1; v < model.size(); v++)
+		if (model[v] == 1)
+			bits[v / 32] |= 1u << (v % 32);
+	
+	if (model_cache.size() >= kModelCacheSize)
+		model_cache.erase(model_cache.begin());
+	model_cache.push_back(bits);
+}
+
+bool SatSolver::IsCachedModelWith(Literal l)
+{
+	for (size_t i = 0; i < model_cache.size(); i++)
+		if (ModelValue(model_cache[i], abs(l)) == (l > 0))
+			return true;
+	return false;
+}
+
+bool SatSolver::HasModel()
+{
+	// With a cached model at hand the clauses are known to be satisfiable; otherwise it takes a
+	// query without query clauses (which the result cache answers after the first time).
+	if (!model_cache.empty())
+		return true;
+	ClearQueryClauses();
+	return MakeQuery(NULL);
+}
+
+static void TestLiteralsWorker(SatSolver* worker, const vector<Literal>* literals, vector<int>* results,
+								atomic<int>* next, int chunk_size)
+{
+	while (true)
+	{
+		int begin = next->fetch_add(chunk_size);
+		if (begin >= (int) literals->size())
+			return;
+		
+		int end = min<int>(begin + chunk_size, literals->size());
+		vector<Literal> chunk(literals->begin() + begin, literals->begin() + end);
+		vector<int> chunk_results = worker->TestLiterals(chunk);
+		copy(chunk_results.begin(), chunk_results.end(), results->begin() + begin);
+	}
+}
+
+vector<int> SatSolver::TestLiteralsParallel(const vector<Literal>& literals, int num_threads)
+{
+	num_threads = min<int>(num_threads, literals.size());
+	if (num_threads <= 1)
+		return TestLiterals(literals);
+	
+	// Chunks are small enough to balance the load, but large enough that TestLiterals can reuse
+	// each model for several literals.
+	int chunk_size = max<int>(1, literals.size() / (num_threads * 4));
+	vector<int> results(literals.size());
+	atomic<int> next(0);
+	
+	vector<SatSolver*> workers;
+	vector<thread> threads;
+	for (int i = 0; i < num_threads; i++)
+	{
+		workers.push_back(new SatSolver(*this));
+		if (workers[i]->backend_choice == kExternalBackend)
+			workers[i]->backend_choice = kAutoBackend;
+		threads.push_back(thread(TestLiteralsWorker, workers[i], &literals, &results, &next, chunk_size));
+	}
+	
+	for (int i = 0; i < num_threads; i++)
+	{
+		threads[i].join();
+		delete workers[i];
+	}
+	return results;
+}
@@ -6,6 +6,9 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <map>
+#include <initializer_list>
+#include <stdint.h>
 
 typedef int Literal;
 typedef std::vector<Literal> Clause;
@@ -15,22 +18,232 @@ const int kFalse = -1;
 const int kUnknown = 0;
 const int kTrue = 1;
 
+// Number of recent models SatSolver keeps to answer queries without solving.
+const int kModelCacheSize = 8;
+
+// Formulas with at most this many literals (permanent plus query clauses) are solved by the
+// DPLL backend when SatSolver picks backends automatically; larger ones go to zChaff.
+const int kDpllMaxLiterals = 256;
+
+// Largest number of query clauses TestLiterals asks for at once, each a run of the polarities
+// that no model has shown yet (see TestLiterals).
+const int kWitnessGroups = 16;
+
+// Number of query results SatSolver remembers before it starts over with an empty result cache.
+const int kResultCacheSize = 4096;
+
+// A 128-bit hash of a set of clauses. Each clause hashes to the mix of the sum of its literals'
+// hashes, and a set of clauses to the sum of its clauses' hashes, so the fingerprint ignores
+// the order of literals and clauses, and adding a clause costs O(clause size).
+struct Fingerprint
+{
+	uint64_t lo, hi;
+	
+	Fingerprint()	{lo = hi = 0;}
+	Fingerprint operator+(const Fingerprint& f) const	{Fingerprint sum;	sum.lo = lo + f.lo;	sum.hi = hi + f.hi;	return sum;}
+	bool operator<(const Fingerprint& f) const			{return lo < f.lo || (lo == f.lo && hi < f.hi);}
+	
+	static Fingerprint OfClause(const Literal* lits, int num_lits);
+	
+	// The same for "at least 'at_least' and at most 'at_most' of lits are true"; a clause is
+	// at_least = 1, at_most = num_lits, and gets the fingerprint OfClause gives it.
+	static Fingerprint OfConstraint(const Literal* lits, int num_lits, int at_least, int at_most);
+};
+
+// A list of clauses stored back to back in one literal array, with an offsets array marking where
+// each clause starts. Adding a clause allocates nothing of its own, and the largest variable and
+// the fingerprint of the clause set are tracked as clauses come in.
+class ClauseArena
+{
+public:
+	ClauseArena()	{offsets.push_back(0);	max_var = 0;}
+	
+	void Add(const Literal* lits, int num_lits);
+	void Clear()	{literals.clear();	offsets.resize(1);	max_var = 0;	fingerprint = Fingerprint();}
+	void Reserve(int num_clauses, int num_literals)	{offsets.reserve(num_clauses + 1);	literals.reserve(num_literals);}
+	
+	int NumClauses() const	{return offsets.size() - 1;}
+	int NumLiterals() const	{return literals.size();}
+	int MaxVar() const		{return max_var;}
+	const Fingerprint& GetFingerprint() const	{return fingerprint;}
+	
+	// A point to come back to: Rewind drops every clause added after GetMark.
+	struct Mark
+	{
+		int num_clauses;
+		int max_var;
+		Fingerprint fingerprint;
+	};
+	Mark GetMark() const	{Mark mark = {NumClauses(), max_var, fingerprint};	return mark;}
+	void Rewind(const Mark& mark)	{literals.resize(offsets[mark.num_clauses]);	offsets.resize(mark.num_clauses + 1);	max_var = mark.max_var;	fingerprint = mark.fingerprint;}
+	
+	// Clause i is the Size(i) literals starting at Begin(i).
+	const Literal* Begin(int i) const	{return literals.data() + offsets[i];}
+	int Size(int i) const				{return offsets[i + 1] - offsets[i];}
+	
+private:
+	std::vector<Literal> literals;
+	std::vector<int> offsets;
+	int max_var;
+	Fingerprint fingerprint;
+};
+
+// Unit propagation at decision level 0 over a ClauseArena, with two watched literals per clause.
+// Sync picks up the clauses added since the last call and propagates them. Value(l) is 1 (-1)
+// if l is implied true (false) by the clauses seen so far and 0 if propagation alone leaves it
+// open. Assignments are only undone by Rewind, when the arena itself is rewound to a mark.
+class UnitPropagator
+{
+public:
+	UnitPropagator()	{Clear();}
+	
+	void Sync(const ClauseArena& clauses);
+	void Clear()	{values.clear();	watches.clear();	watched.clear();	trail.clear();	num_propagated = num_synced = 0;	inconsistent = false;}
+	
+	int Value(Literal l) const	{int v = abs(l);	return v < (int) values.size() ? (l > 0 ? values[v] : -values[v]) : 0;}
+	bool IsInconsistent() const	{return inconsistent;}	// propagation derived the empty clause
+	
+	// Rewind(mark, clauses) undoes the assignments made since GetMark and forgets the clauses
+	// synced since, whose watches it finds in 'clauses'; so it must come before the arena's own
+	// Rewind. Watches that moved in the meantime stay where they are, which is still valid once
+	// the assignments that moved them are undone.
+	struct Mark
+	{
+		int trail_size;
+		int num_propagated;
+		int num_synced;
+		bool inconsistent;
+	};
+	Mark GetMark() const	{Mark mark = {(int) trail.size(), num_propagated, num_synced, inconsistent};	return mark;}
+	void Rewind(const Mark& mark, const ClauseArena& clauses);
+	
+private:
+	static int Index(Literal l)	{return 2 * abs(l) + (l < 0);}
+	void Assign(Literal l);
+	void Propagate(const ClauseArena& clauses);
+	
+	std::vector<signed char> values;			// by variable: 1, -1 or 0
+	std::vector<std::vector<int> > watches;		// by Index(l): clauses watching l
+	std::vector<int> watched;					// two watched positions per clause, -1 if unwatched
+	std::vector<Literal> trail;					// implied literals, in order
+	int num_propagated;							// entries of 'trail' whose watches have been visited
+	int num_synced;								// clauses of the arena seen so far
+	bool inconsistent;
+};
+
+class SolverBackend;
+
+enum BackendChoice
+{
+	kAutoBackend,		// DPLL up to kDpllMaxLiterals, in-process zChaff above
+	kDpllBackend,
+	kZchaffBackend,
+	kExternalBackend
+};
+
 class SatSolver
 {
 public:
-	SatSolver(){}
-	~SatSolver(){}
+	SatSolver();
+	SatSolver(const SatSolver& other);	// copies the clauses and caches; starts its own backends
+	~SatSolver();
+	
+	void AddClause(const Literal* lits, int num_lits);
+	void AddClause(const Clause& c)					{AddClause(c.data(), c.size());}
+	void AddClause(std::initializer_list<Literal> c)	{AddClause(c.begin(), c.size());}
+	void ClearClauses();
+	void ReserveClauses(int num_clauses, int num_literals)	{clauses.Reserve(num_clauses, num_literals);}
+	int NumClauses() const	{return clauses.NumClauses();}
+	int NumLiterals() const	{return clauses.NumLiterals();}
+	int MaxVar() const		{return clauses.MaxVar();}
+	const ClauseArena& GetClauses() const	{return clauses;}
 	
-	void AddClause(Clause c)		{clauses.push_back(c);}
-	void ClearClauses() 			{clauses.clear();}
-	void AddQueryClause(Clause c) 	{query_clauses.push_back(c);}
-	void ClearQueryClauses()	{query_clauses.clear();}
+	// What-if frames. Push remembers the current clause set; Pop drops every clause added since
+	// the matching Push, together with what was derived from them (propagated units, zChaff's
+	// learned clauses, units TestLiterals found entailed), so trying a hypothesis costs only its
+	// own clauses. Frames nest; ClearClauses drops them all.
+	void Push();
+	void Pop();
+	int NumFrames() const	{return frames.size();}
+	
+	// The value unit propagation alone gives l under the current clauses (kTrue, kFalse or
+	// kUnknown), or kContradiction if it derives the empty clause. No solver call is made, so
+	// kUnknown does not mean both values are possible.
+	int PropagatedValue(Literal l);
+	
+	void AddQueryClause(const Literal* lits, int num_lits)	{query_clauses.Add(lits, num_lits);}
+	void AddQueryClause(const Clause& c)					{query_clauses.Add(c.data(), c.size());}
+	void AddQueryClause(std::initializer_list<Literal> c)	{query_clauses.Add(c.begin(), c.size());}
+	void ClearQueryClauses()	{query_clauses.Clear();}
+	
+	// Picks the backend that solves queries (see SolverBackend.h); by default it is chosen per
+	// query from the formula size. SetUseExternalSolver(true) is SetBackend(kExternalBackend),
+	// which runs ./zchaff on each query.
+	void SetBackend(BackendChoice choice)	{backend_choice = choice;}
+	void SetUseExternalSolver(bool use)		{backend_choice = use ? kExternalBackend : kAutoBackend;}
 	
 	bool MakeQuery();
+	
+	// Literals that unit propagation over the clauses already settles are answered without a
+	// solver call (beyond, at most, one check that the clauses are satisfiable at all).
 	int TestLiteral(Literal l);
 	
+	// Answers TestLiteral for a whole batch of literals (same return codes, same order) in one
+	// solver session: every model found along the way rules out the polarities it already shows
+	// to be possible, and each query asks for a model showing several of the polarities still
+	// unseen, so the number of solver calls grows with how many models it takes to show every
+	// possible polarity rather than with the number of literals.
+	std::vector<int> TestLiterals(const std::vector<Literal>& literals);
+	
+	// Same as TestLiterals, but spread over 'num_threads' worker threads. Each worker owns a copy
+	// of this solver (and so its own zChaff session) and takes chunks of literals off a shared
+	// counter; results come back in input order. Workers never use the external backend, since
+	// spawning a process per query would defeat the point.
+	std::vector<int> TestLiteralsParallel(const std::vector<Literal>& literals, int num_threads);
+	
+	// Every query result is remembered under the fingerprint of the permanent plus query clauses,
+	// so asking the same question about the same clause set again costs no solver call.
+	long GetCacheHits() const	{return cache_hits;}
+	long GetCacheMisses() const	{return cache_misses;}
+	
 private:
-	std::vector<Clause> clauses;
-	std::vector<Clause> query_clauses;
+	SatSolver& operator=(const SatSolver&);
+	
+	// 'model', if given, receives the value (1, 0, or -1 if unassigned) of every variable,
+	// indexed by variable, whenever the query is satisfiable and was not answered from the
+	// result cache (it is left empty otherwise).
+	bool MakeQuery(std::vector<int>* model);
+	SolverBackend* PickBackend();
+	static bool RecordModel(const std::vector<int>& model, std::vector<bool>& can_be_true, std::vector<bool>& can_be_false);
+	static bool IsWellFormed(const std::vector<int>& model);
+	
+	// Recent models of 'clauses', as bitsets of the variables that are true (variables past the
+	// end are false). AddClause drops every cached model the new clause is false in, so each
+	// cached model satisfies the current clause set, and a query that some cached model
+	// already satisfies needs no solver call.
+	typedef std::vector<unsigned> ModelBits;
+	static bool ModelValue(const ModelBits& bits, int var);
+	void CacheModel(const std::vector<int>& model);
+	bool IsCachedModelWith(Literal l);
+	bool HasModel();
+	
+	// What Pop goes back to. Models found inside a frame satisfy fewer clauses after Pop, so they
+	// stay cached, next to the ones the frame's clauses dropped.
+	struct Frame
+	{
+		ClauseArena::Mark clauses;
+		UnitPropagator::Mark propagator;
+		std::vector<ModelBits> model_cache;
+	};
+	
+	ClauseArena clauses;
+	ClauseArena query_clauses;
+	BackendChoice backend_choice;
+	SolverBackend* backends[kExternalBackend + 1];	// by BackendChoice, created on first use
+	std::vector<ModelBits> model_cache;	// oldest first, at most kModelCacheSize entries
+	std::map<Fingerprint, bool> result_cache;	// clause set fingerprint -> satisfiable
+	UnitPropagator propagator;
+	std::vector<Frame> frames;			// innermost last
+	long cache_hits, cache_misses;
 };
 #endif
@@ -0,0 +1,392 @@
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "SolverBackend.h"
+#include "SAT.h"
+#include "bin_cnf.h"
+using namespace std;
+
+void ZchaffBackend::Reset()
+{
+	if (session)
+		SAT_ReleaseManager(session);
+	session = NULL;
+	frames.clear();
+}
+
+void ZchaffBackend::SyncSession(const ClauseArena& clauses)
+{
+	if (!session)
+	{
+		session = SAT_InitManager();
+		SAT_SetVerbosity(session, -1);
+		session_vars = 0;
+		session_clauses = 0;
+		session_empty_clause = -1;
+	}
+	
+	// Clauses can only be added or deleted while the solver is reset.
+	SAT_Reset(session);
+	for (; session_clauses < clauses.NumClauses(); session_clauses++)
+		if (!AddSessionClause(clauses.Begin(session_clauses), clauses.Size(session_clauses), GroupOf(session_clauses)))
+			if (session_empty_clause < 0)
+				session_empty_clause = session_clauses;
+}
+
+int ZchaffBackend::GroupOf(int clause)
+{
+	// Frames start in increasing order, so the innermost one starting at or before 'clause' holds it.
+	int f = frames.size() - 1;
+	while (f >= 0 && frames[f].first_clause > clause)
+		f--;
+	if (f < 0)
+		return 0;
+	if (frames[f].gid == 0)
+		frames[f].gid = SAT_AllocClauseGroupID(session);
+	return frames[f].gid;
+}
+
+void ZchaffBackend::Push(int first_clause)
+{
+	Frame frame = {first_clause, 0};
+	frames.push_back(frame);
+}
+
+void ZchaffBackend::Pop()
+{
+	if (frames.empty())
+		return;
+	Frame frame = frames.back();
+	frames.pop_back();
+	if (!session)
+		return;
+	
+	// Deleting the group also deletes the learned clauses that were derived from it.
+	if (frame.gid != 0)
+	{
+		SAT_Reset(session);
+		SAT_DeleteClauseGroup(session, frame.gid);
+	}
+	session_clauses = min(session_clauses, frame.first_clause);
+	if (session_empty_clause >= frame.first_clause)
+		session_empty_clause = -1;
+}
+
+bool ZchaffBackend::AddSessionClause(const Literal* c, int num_lits, int gid)
+{
+	// Returns false if the clause is empty, i.e. unsatisfiable on its own.
+	if (num_lits == 0)
+		return false;
+	
+	// zChaff literals are 2 * var + sign. Like read_cnf in zchaff-src/sat_solver.cpp, drop repeated
+	// literals and skip tautologies, since the library requires every clause to be non-redundant.
+	vector<int>& lits = session_lits;
+	lits.clear();
+	for (int j = 0; j < num_lits; j++)
+	{
+		int var = abs(c[j]);
+		while (session_vars < var)
+			session_vars = SAT_AddVariable(session);
+		lits.push_back(2 * var + (c[j] < 0));
+	}
+	sort(lits.begin(), lits.end());
+	lits.erase(unique(lits.begin(), lits.end()), lits.end());
+	
+	for (size_t j = 1; j < lits.size(); j++)
+		if ((lits[j] >> 1) == (lits[j-1] >> 1))
+			return true;
+	
+	SAT_AddClause(session, &lits[0], lits.size(), gid);
+	return true;
+}
+
+bool ZchaffBackend::Solve(const ClauseArena& clauses, const ClauseArena& query_clauses, vector<int>* model)
+{
+	SyncSession(clauses);
+	if (session_empty_clause >= 0)
+		return false;
+	
+	int gid = SAT_AllocClauseGroupID(session);
+	bool satisfiable = true;
+	for (int i = 0; i < query_clauses.NumClauses(); i++)
+		if (!AddSessionClause(query_clauses.Begin(i), query_clauses.Size(i), gid))
+			satisfiable = false;
+	
+	// zChaff's reset does nothing while it has no variables, so a solve would just repeat the last
+	// outcome; with no variables every clause is empty or absent, and the latter is handled above.
+	if (satisfiable && session_vars > 0)
+		satisfiable = (SAT_Solve(session) == SATISFIABLE);
+	
+	if (satisfiable && model)
+	{
+		model->assign(session_vars + 1, -1);
+		for (int v = 1; v <= session_vars; v++)
+		{
+			int value = SAT_GetVarAsgnment(session, v);
+			(*model)[v] = (value == UNKNOWN ? -1 : value);
+		}
+	}
+	
+	// Deleting the group also deletes the learned clauses that were derived from it.
+	SAT_DeleteClauseGroup(session, gid);
+	SAT_Reset(session);
+	return satisfiable;
+}
+
+void ZchaffBackend::AddEntailedClause(const Literal* lits, int num_lits)
+{
+	// Only worth it for a session that is already loaded; a new one starts from the clauses. Inside
+	// a frame the clause may depend on the frame's clauses, so it goes into the frame's group.
+	if (session)
+		AddSessionClause(lits, num_lits, frames.empty() ? 0 : GroupOf(frames.back().first_clause));
+}
+
+int ExternalBackend::WriteBinaryQuery(const ClauseArena& clauses, const ClauseArena& query_clauses)
+{
+	// Returns a file descriptor holding the permanent and query clauses in the binary format of
+	// zchaff-src/bin_cnf.h, or -1 if no shared memory file could be set up. The file is anonymous
+	// and not close-on-exec, so a child process can map it as /dev/fd/N.
+#ifdef __linux__
+	int fd = memfd_create("query.bcnf", 0);
+#else
+	FILE* tmp = tmpfile();
+	int fd = tmp ? dup(fileno(tmp)) : -1;
+	if (tmp)
+		fclose(tmp);
+#endif
+	if (fd < 0)
+		return -1;
+	
+	int num_clauses = clauses.NumClauses() + query_clauses.NumClauses();
+	int num_lits = clauses.NumLiterals() + query_clauses.NumLiterals();
+	long size = bin_cnf_size(num_clauses, num_lits);
+	void* region = MAP_FAILED;
+	if (ftruncate(fd, size) == 0)
+		region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (region == MAP_FAILED)
+	{
+		close(fd);
+		return -1;
+	}
+	
+	BinCnfHeader* header = (BinCnfHeader*) region;
+	header->magic = BIN_CNF_MAGIC;
+	header->version = BIN_CNF_VERSION;
+	header->num_vars = max(clauses.MaxVar(), query_clauses.MaxVar());
+	header->num_clauses = num_clauses;
+	header->num_lits = num_lits;
+	
+	int* out = (int*) (header + 1);
+	const ClauseArena* arenas[2] = {&clauses, &query_clauses};
+	for (int a = 0; a < 2; a++)
+		for (int i = 0; i < arenas[a]->NumClauses(); i++)
+		{
+			memcpy(out, arenas[a]->Begin(i), arenas[a]->Size(i) * sizeof(Literal));
+			out += arenas[a]->Size(i);
+			*out++ = 0;
+		}
+	
+	munmap(region, size);
+	return fd;
+}
+
+void ExternalBackend::WriteDimacsQuery(const ClauseArena& clauses, const ClauseArena& query_clauses, const char* filename)
+{
+	// Print out the CNF query file: the permanent clauses followed by the query clauses.
+	ofstream dimacs;
+	dimacs.open(filename);
+	dimacs<<"c This DIMACS format CNF file was generated by SatSolver.cpp"<<endl;
+	dimacs<<"c Do not edit."<<endl;
+	
+	dimacs<<"p cnf "<<max(clauses.MaxVar(), query_clauses.MaxVar())<<" "<<clauses.NumClauses() + query_clauses.NumClauses()<<"\n";
+	
+	const ClauseArena* arenas[2] = {&clauses, &query_clauses};
+	for (int a = 0; a < 2; a++)
+		for (int i = 0; i < arenas[a]->NumClauses(); i++)
+		{
+			const Literal* lits = arenas[a]->Begin(i);
+			for (int j = 0; j < arenas[a]->Size(i); j++)
+				dimacs<<lits[j]<<" ";
+			
+			dimacs<<"0\n";
+		}
+	dimacs.close();
+}
+
+bool ExternalBackend::Solve(const ClauseArena& clauses, const ClauseArena& query_clauses, vector<int>* model)
+{
+	int max_var = max(clauses.MaxVar(), query_clauses.MaxVar());
+	
+	// zChaff's DIMACS reader drops empty clauses, so a query holding one is answered here.
+	const ClauseArena* arenas[2] = {&clauses, &query_clauses};
+	for (int a = 0; a < 2; a++)
+		for (int i = 0; i < arenas[a]->NumClauses(); i++)
+			if (arenas[a]->Size(i) == 0)
+				return false;
+	
+	// Hand the clauses over in binary through shared memory; if that cannot be set up, fall back
+	// to a DIMACS file.
+	string command;
+	int fd = WriteBinaryQuery(clauses, query_clauses);
+	if (fd >= 0)
+	{
+		ostringstream args;
+		args<<"./zchaff -bin /dev/fd/"<<fd;
+		command = args.str();
+	}
+	else
+	{
+		WriteDimacsQuery(clauses, query_clauses, "query.cnf");
+		command = "./zchaff query.cnf";
+	}
+	
+	// Call zChaff with the query file and read its result.
+	FILE* pipe = popen(command.c_str(), "r");
+	if (!pipe)
+	{
+		cerr<<"SatSolver: could not run "<<command<<endl;
+		if (fd >= 0)
+			close(fd);
+		return false;
+	}
+	char buffer[128];
+	string result = "";
+	while (fgets(buffer, sizeof(buffer), pipe) != NULL)
+		result += buffer;
+	pclose(pipe);
+	if (fd >= 0)
+		close(fd);
+	
+	if (result.find("RESULT:\tSAT") == string::npos)
+		return false;
+	
+	// zChaff prints the assignment on the line after "Instance Satisfiable", e.g. "1 -2 (3) 4",
+	// where (3) means variable 3 was left unassigned.
+	const char* header = "Instance Satisfiable\n";
+	size_t model_start = result.find(header);
+	if (model && model_start != string::npos)
+	{
+		model_start += strlen(header);
+		istringstream line(result.substr(model_start, result.find('\n', model_start) - model_start));
+		model->assign(max_var + 1, -1);
+		string token;
+		for (int v = 1; line>>token && v <= max_var; v++)
+			if (token[0] != '(')
+				(*model)[v] = (token[0] != '-');
+	}
+	return true;
+}
+
+bool DpllBackend::Solve(const ClauseArena& clauses, const ClauseArena& query_clauses, vector<int>* model)
+{
+	int max_var = max(clauses.MaxVar(), query_clauses.MaxVar());
+	literals.clear();
+	const ClauseArena* arenas[2] = {&clauses, &query_clauses};
+	for (int a = 0; a < 2; a++)
+		for (int i = 0; i < arenas[a]->NumClauses(); i++)
+		{
+			literals.insert(literals.end(), arenas[a]->Begin(i), arenas[a]->Begin(i) + arenas[a]->Size(i));
+			literals.push_back(0);
+		}
+	values.assign(max_var + 1, 0);
+	trail.clear();
+	
+	if (!Search())
+		return false;
+	
+	// Variables the search never had to assign are free.
+	if (model)
+	{
+		model->assign(max_var + 1, -1);
+		for (int v = 1; v <= max_var; v++)
+			if (values[v] != 0)
+				(*model)[v] = (values[v] > 0);
+	}
+	return true;
+}
+
+bool DpllBackend::Propagate()
+{
+	// Scans the clauses until none is unit; returns false if one is falsified.
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (size_t i = 0; i < literals.size(); i++)
+		{
+			bool satisfied = false;
+			int num_open = 0;
+			Literal open = 0;
+			for (; literals[i] != 0; i++)
+			{
+				int value = (literals[i] > 0 ? values[literals[i]] : -values[-literals[i]]);
+				if (value > 0)
+					satisfied = true;
+				else if (value == 0 && literals[i] != open)
+				{
+					num_open++;
+					open = literals[i];
+				}
+			}
+			
+			if (satisfied || num_open > 1)
+				continue;
+			if (num_open == 0)
+				return false;
+			values[abs(open)] = (open > 0 ? 1 : -1);
+			trail.push_back(abs(open));
+			changed = true;
+		}
+	}
+	return true;
+}
+
+bool DpllBackend::Search()
+{
+	size_t trail_size = trail.size();
+	if (!Propagate())
+	{
+		for (; trail.size() > trail_size; trail.pop_back())
+			values[trail.back()] = 0;
+		return false;
+	}
+	
+	// Branch on the first open literal of the first clause that is not yet satisfied.
+	Literal branch = 0;
+	for (size_t i = 0; i < literals.size() && branch == 0; i++)
+	{
+		bool satisfied = false;
+		Literal open = 0;
+		for (; literals[i] != 0; i++)
+		{
+			int value = (literals[i] > 0 ? values[literals[i]] : -values[-literals[i]]);
+			if (value > 0)
+				satisfied = true;
+			else if (value == 0 && open == 0)
+				open = literals[i];
+		}
+		if (!satisfied)
+			branch = open;
+	}
+	if (branch == 0)
+		return true;
+	
+	for (int sign = 1; sign >= -1; sign -= 2)
+	{
+		size_t branch_size = trail.size();
+		values[abs(branch)] = (sign * branch > 0 ? 1 : -1);
+		trail.push_back(abs(branch));
+		if (Search())
+			return true;
+		for (; trail.size() > branch_size; trail.pop_back())
+			values[trail.back()] = 0;
+	}
+	
+	for (; trail.size() > trail_size; trail.pop_back())
+		values[trail.back()] = 0;
+	return false;
+}
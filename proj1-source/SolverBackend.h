@@ -0,0 +1,99 @@
+#ifndef SOLVER_BACKEND_H
+#define SOLVER_BACKEND_H
+
+#include <vector>
+#include "SatSolver.h"
+
+// A way of deciding whether the permanent clauses plus the query clauses are satisfiable.
+// SatSolver keeps one backend of each kind it has used and picks one per query (see
+// SatSolver::SetBackend).
+class SolverBackend
+{
+public:
+	virtual ~SolverBackend() {}
+
+	// 'model', if given, receives the value (1, 0, or -1 if unassigned) of every variable,
+	// indexed by variable, whenever the query is satisfiable; it may be left empty if the
+	// backend cannot report one. Between calls 'clauses' only grows, unless Reset is called.
+	virtual bool Solve(const ClauseArena& clauses, const ClauseArena& query_clauses, std::vector<int>* model) = 0;
+
+	// Called when the permanent clauses are cleared.
+	virtual void Reset() {}
+
+	// A clause the permanent clauses are known to entail. A backend that keeps state between
+	// queries may add it to save re-deriving it; others can ignore it.
+	virtual void AddEntailedClause(const Literal* /*lits*/, int /*num_lits*/) {}
+	
+	// A what-if frame (see SatSolver::Push) starting at permanent clause 'first_clause'. After the
+	// matching Pop, 'clauses' is back to its first 'first_clause' clauses, and anything derived
+	// from the ones after (entailed clauses included) must be forgotten.
+	virtual void Push(int /*first_clause*/) {}
+	virtual void Pop() {}
+};
+
+// The zChaff library (zchaff-src/libsat.a), in-process. It is a single zChaff manager that lives
+// as long as the clause set does. Permanent clauses are loaded into it once (group 0); query
+// clauses go into a clause group that is deleted after each query, so learned clauses and
+// variable scores that only depend on the permanent clauses carry over from one query to the next.
+// Permanent clauses added inside a what-if frame go into a clause group of their own, which Pop
+// deletes, along with everything zChaff learned from it.
+class ZchaffBackend : public SolverBackend
+{
+public:
+	ZchaffBackend()		{session = NULL;}
+	~ZchaffBackend()	{Reset();}
+
+	bool Solve(const ClauseArena& clauses, const ClauseArena& query_clauses, std::vector<int>* model);
+	void Reset();
+	void AddEntailedClause(const Literal* lits, int num_lits);
+	void Push(int first_clause);
+	void Pop();
+
+private:
+	struct Frame
+	{
+		int first_clause;
+		int gid;				// 0 until a clause of the frame is loaded into 'session'
+	};
+	
+	void SyncSession(const ClauseArena& clauses);
+	bool AddSessionClause(const Literal* lits, int num_lits, int gid);
+	int GroupOf(int clause);	// the group permanent clause 'clause' is loaded into
+
+	void* session;				// SAT_Manager, see zchaff-src/SAT.h
+	int session_vars;			// number of variables allocated in 'session'
+	int session_clauses;		// number of permanent clauses already loaded into 'session'
+	int session_empty_clause;	// the first empty permanent clause loaded, -1 if none
+	std::vector<int> session_lits;	// scratch buffer for AddSessionClause
+	std::vector<Frame> frames;	// innermost last
+};
+
+// The zchaff binary in the working directory, run once per query. The clauses are handed over
+// through shared memory in zChaff's binary CNF format (zchaff-src/bin_cnf.h), or in query.cnf
+// if that is unavailable.
+class ExternalBackend : public SolverBackend
+{
+public:
+	bool Solve(const ClauseArena& clauses, const ClauseArena& query_clauses, std::vector<int>* model);
+
+private:
+	static int WriteBinaryQuery(const ClauseArena& clauses, const ClauseArena& query_clauses);
+	static void WriteDimacsQuery(const ClauseArena& clauses, const ClauseArena& query_clauses, const char* filename);
+};
+
+// A plain recursive DPLL search with unit propagation by clause scanning. It has no setup cost,
+// so it is the fastest choice for formulas of a few hundred literals, and hopeless beyond that.
+class DpllBackend : public SolverBackend
+{
+public:
+	bool Solve(const ClauseArena& clauses, const ClauseArena& query_clauses, std::vector<int>* model);
+
+private:
+	bool Propagate();
+	bool Search();
+
+	std::vector<Literal> literals;	// permanent and query clauses, each terminated by 0
+	std::vector<signed char> values;	// by variable: 1, -1 or 0
+	std::vector<int> trail;			// assigned variables, in order
+};
+#endif
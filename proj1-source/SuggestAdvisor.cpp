@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "SuggestAdvisor.h"
+using namespace std;
+
+// One way a suggestion can turn out: 'refuter' shows 'card_shown', or nobody refutes (kNone).
+struct Outcome
+{
+	int refuter, card_shown;
+	double weight;
+};
+
+static bool BetterScore(const SuggestionScore& a, const SuggestionScore& b)
+{
+	return a.expected_cells > b.expected_cells;
+}
+
+vector<SuggestionScore> SuggestAdvisor::Rank()
+{
+	vector<SuggestionScore> scores;
+	reasoner->UpdateNotepad();
+	if (reasoner->player_num < 0 || reasoner->contradiction)
+		return scores;
+	suggester = reasoner->player_num;
+	const GameConfig& config = reasoner->GetConfig();
+	
+	open_cells.clear();
+	chance.assign(config.NumCards() * config.NumPlaces(), 0);
+	for (int c = 0; c < config.NumCards(); c++)
+	{
+		int num_open = 0;
+		for (int p = 0; p < config.NumPlaces(); p++)
+			if (reasoner->Cell(c, p) == kUnknown)
+			{
+				num_open++;
+				open_cells.push_back(reasoner->GetPairNum(p, c));
+			}
+		for (int p = 0; p < config.NumPlaces(); p++)
+			chance[c * config.NumPlaces() + p] = (reasoner->Cell(c, p) == kTrue) ? 1 : (reasoner->Cell(c, p) == kUnknown) ? 1.0 / num_open : 0;
+	}
+	
+	for (int s = 0; s < config.CategorySize(0); s++)
+		for (int w = 0; w < config.CategorySize(1); w++)
+			for (int r = 0; r < config.CategorySize(2); r++)
+			{
+				SuggestionScore score;
+				score.cards[0] = config.CategoryFirst(0) + s;
+				score.cards[1] = config.CategoryFirst(1) + w;
+				score.cards[2] = config.CategoryFirst(2) + r;
+				score.expected_cells = 0;
+				score.num_outcomes = 0;
+				scores.push_back(score);
+			}
+	
+	// Every Push is matched by a Pop, so a single worker can use the reasoner's own solver and
+	// keep what it has cached. More workers each take a copy and pull candidates off a shared
+	// counter.
+	int workers = min<int>(num_threads, scores.size());
+	if (workers <= 1)
+		for (size_t i = 0; i < scores.size(); i++)
+			Score(reasoner->solver, scores[i]);
+	else
+	{
+		atomic<int> next(0);
+		vector<SatSolver*> solvers;
+		vector<thread> threads;
+		for (int w = 0; w < workers; w++)
+		{
+			SatSolver* solver = new SatSolver(*reasoner->solver);
+			solvers.push_back(solver);
+			threads.push_back(thread([this, &scores, &next, solver]()
+			{
+				for (int i = next++; i < (int) scores.size(); i = next++)
+					Score(solver, scores[i]);
+			}));
+		}
+		for (int w = 0; w < workers; w++)
+		{
+			threads[w].join();
+			delete solvers[w];
+		}
+	}
+	
+	stable_sort(scores.begin(), scores.end(), BetterScore);
+	return scores;
+}
+
+void SuggestAdvisor::Score(SatSolver* solver, SuggestionScore& score)
+{
+	// Player p refutes with card c if the players asked before p hold none of the suggested cards
+	// and p holds c.
+	const GameConfig& config = reasoner->GetConfig();
+	const int* suggested = score.cards;
+	vector<Outcome> outcomes;
+	double none_before = 1;
+	for (int p = (suggester + 1) % config.NumPlayers(); p != suggester; p = (p + 1) % config.NumPlayers())
+	{
+		for (int k = 0; k < num_categories; k++)
+		{
+			Outcome outcome = {p, suggested[k], none_before * chance[suggested[k] * config.NumPlaces() + p]};
+			if (outcome.weight > 0)
+				outcomes.push_back(outcome);
+		}
+		for (int k = 0; k < num_categories; k++)
+			none_before *= 1 - chance[suggested[k] * config.NumPlaces() + p];
+	}
+	Outcome nobody = {kNone, kNone, none_before};
+	if (nobody.weight > 0)
+		outcomes.push_back(nobody);
+	
+	double total_weight = 0, total_cells = 0;
+	for (size_t i = 0; i < outcomes.size(); i++)
+	{
+		// The clauses ClueReasoner::Suggest would add for this outcome.
+		solver->Push();
+		int last = (outcomes[i].refuter == kNone) ? suggester : outcomes[i].refuter;
+		for (int p = (suggester + 1) % config.NumPlayers(); p != last; p = (p + 1) % config.NumPlayers())
+			for (int k = 0; k < num_categories; k++)
+				solver->AddClause({-reasoner->GetPairNum(p, suggested[k])});
+		if (outcomes[i].refuter != kNone)
+			solver->AddClause({reasoner->GetPairNum(outcomes[i].refuter, outcomes[i].card_shown)});
+		
+		int cells = SettledCells(solver);
+		solver->Pop();
+		if (cells < 0)
+			continue;
+		
+		score.num_outcomes++;
+		total_weight += outcomes[i].weight;
+		total_cells += outcomes[i].weight * cells;
+	}
+	score.expected_cells = (total_weight > 0) ? total_cells / total_weight : 0;
+}
+
+int SuggestAdvisor::SettledCells(SatSolver* solver)
+{
+	if (open_cells.empty())
+		return 0;
+	
+	int settled = 0;
+	if (use_solver)
+	{
+		vector<int> results = solver->TestLiterals(open_cells);
+		if (results[0] == kContradiction)
+			return -1;
+		for (size_t i = 0; i < results.size(); i++)
+			settled += (results[i] != kUnknown);
+		return settled;
+	}
+	
+	for (size_t i = 0; i < open_cells.size(); i++)
+	{
+		int value = solver->PropagatedValue(open_cells[i]);
+		if (value == kContradiction)
+			return -1;
+		settled += (value != kUnknown);
+	}
+	return settled;
+}
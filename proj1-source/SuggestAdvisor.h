@@ -0,0 +1,50 @@
+#ifndef SUGGEST_ADVISOR_H
+#define SUGGEST_ADVISOR_H
+
+#include <vector>
+#include "ClueReasoner.h"
+
+// A suggestion the current player could make, and what its outcome is expected to tell them.
+struct SuggestionScore
+{
+	int cards[num_categories];	// suspect, weapon, room (see CardId)
+	double expected_cells;		// open notepad cells the outcome is expected to settle
+	int num_outcomes;			// outcomes that are still possible
+};
+
+// Ranks the suspects * weapons * rooms suggestions the reasoner's player could make
+// next by expected information: the number of open notepad cells the outcome would settle,
+// averaged over the outcomes (nobody refutes, or player p shows card c) that are still possible.
+//
+// Each outcome is tried as a what-if on a copy of the reasoner's solver: Push, the clauses that
+// Suggest would add, a look at the open cells, Pop. By default a cell counts as settled if unit
+// propagation settles it, which keeps a full ranking to about 10 ms. With 'use_solver' the cells
+// are checked with TestLiterals instead, which also finds what only search can show, but costs
+// thousands of solver calls per ranking (tens of seconds), so it is for analysis, not play. An
+// outcome is weighed by how likely the notepad makes it, taking each
+// card to be at each of its open places with equal chance, independently of the other cards.
+// Candidates are spread over 'num_threads' threads, each with its own copy of the solver.
+class SuggestAdvisor
+{
+public:
+	SuggestAdvisor(ClueReasoner* reasoner, int num_threads = 1, bool use_solver = false)
+		{this->reasoner = reasoner;	this->num_threads = num_threads;	this->use_solver = use_solver;}
+	
+	// Best first. Empty if the reasoner has no player yet (see ClueReasoner::Hand) or its
+	// clauses are contradictory.
+	std::vector<SuggestionScore> Rank();
+	
+private:
+	void Score(SatSolver* solver, SuggestionScore& score);
+	int SettledCells(SatSolver* solver);	// -1 if the outcome is impossible
+	
+	ClueReasoner* reasoner;
+	int num_threads;
+	bool use_solver;
+	
+	// Set up by Rank for the workers, which only read them.
+	int suggester;
+	std::vector<double> chance;					// by card, then place, as ClueReasoner's notepad
+	std::vector<Literal> open_cells;			// pair literals of the notepad's open cells
+};
+#endif
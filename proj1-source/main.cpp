@@ -1,6 +1,10 @@
 #include <iostream>
+#include <sstream>
+#include <thread>
 #include "SatSolver.h"
 #include "ClueReasoner.h"
+#include "GameFarm.h"
+#include "SuggestAdvisor.h"
 
 using namespace std;
 
@@ -42,6 +46,40 @@ void TestSatSolver()
 		cout<<"Unknown."<<endl;
 }
 
+void TestSolverBackends()
+{
+	// Queries that every backend must answer alike, starting with a solver that has already
+	// answered a query with no variables at all. The external backend needs "make zchaff".
+	const char* names[] = {"auto", "dpll", "zchaff", "external"};
+	for (int b = kDpllBackend; b <= kExternalBackend; b++)
+	{
+		bool ok = true;
+		
+		SatSolver empty_clause;
+		empty_clause.SetBackend((BackendChoice) b);
+		empty_clause.AddClause({1, 2});
+		empty_clause.AddClause(Clause());
+		ok &= !empty_clause.MakeQuery();
+		
+		SatSolver contradiction;
+		contradiction.SetBackend((BackendChoice) b);
+		ok &= contradiction.MakeQuery();
+		contradiction.AddClause({1});
+		contradiction.AddClause({-1});
+		ok &= !contradiction.MakeQuery();
+		
+		SatSolver implied;
+		implied.SetBackend((BackendChoice) b);
+		ok &= (implied.TestLiterals({7})[0] == kUnknown);
+		implied.AddClause({-7, 4});
+		implied.AddClause({-4});
+		ok &= (implied.TestLiterals({7})[0] == kFalse);
+		ok &= (implied.TestLiteral(7) == kFalse);
+		
+		cout<<names[b]<<": "<<(ok ? "ok" : "FAILED")<<endl;
+	}
+}
+
 void TestClueReasoner()
 {
 	ClueReasoner cr;
@@ -78,9 +116,87 @@ void TestClueReasoner()
 	cr.PrintNotepad();
 }
 
+void TestReplayLog()
+{
+	// The same game as TestClueReasoner, as a transcript.
+	istringstream log(
+		"hand sc wh li st\n"
+		"suggest sc sc ro lo mu sc\n"
+		"suggest mu pe pi di pe -\n"
+		"suggest wh mu re ba pe -\n"
+		"suggest gr wh kn ba pl -\n"
+		"suggest pe gr ca di wh -\n"
+		"suggest pl wh wr st sc wh\n"
+		"suggest sc pl ro co mu pl\n"
+		"suggest mu pe ro ba wh -\n"
+		"suggest wh mu ca st gr -\n"
+		"suggest gr pe kn di pe -\n"
+		"suggest pe mu pi di pl -\n"
+		"suggest pl gr kn co wh -\n"
+		"suggest sc pe kn lo mu lo\n"
+		"suggest mu pe kn di wh -\n"
+		"suggest wh pe wr ha gr -\n"
+		"suggest gr wh pi co pl -\n"
+		"suggest pe sc pi ha mu -\n"
+		"suggest pl pe pi ba - -\n"
+		"suggest sc wh pi ha pe ha\n"
+		"suggest wh pe pi ha pe -\n"
+		"suggest pe pe pi ha - -\n"
+		"suggest sc gr pi st wh gr\n"
+		"suggest mu pe pi ba pl -\n"
+		"suggest wh pe pi st sc st\n"
+		"suggest gr wh pi st sc wh\n"
+		"suggest pe wh pi st sc wh\n"
+		"suggest pl pe pi ki gr -\n");
+	
+	ClueReasoner cr;
+	if (cr.ReplayLog(log))
+		cr.PrintNotepad();
+	
+	// A trailing token, a card shown that was not suggested, and a card shown with no refuter.
+	const char* bad_lines[] = {"suggest sc sc ro lo mu sc lo\n", "suggest sc sc ro lo mu wh\n", "suggest sc sc ro lo - sc\n"};
+	for (int i = 0; i < 3; i++)
+	{
+		istringstream bad_log(bad_lines[i]);
+		ClueReasoner other;
+		if (other.ReplayLog(bad_log))
+			cout<<"Accepted: "<<bad_lines[i];
+	}
+}
+
+void TestGameFarm()
+{
+	GameFarm farm(std::thread::hardware_concurrency());
+	GameFarm::PrintStats(farm.Run(200));
+}
+
+void TestSuggestAdvisor()
+{
+	ClueReasoner cr;
+	string hand[3] = {"wh", "li", "st"};
+	cr.Hand("sc", hand);
+	cr.Suggest("sc", "sc", "ro", "lo", "mu", "sc");
+	cr.Suggest("mu", "pe", "pi", "di", "pe", "");
+	cr.Suggest("wh", "mu", "re", "ba", "pe", "");
+	cr.Suggest("gr", "wh", "kn", "ba", "pl", "");
+	cr.Suggest("pe", "gr", "ca", "di", "wh", "");
+	cr.Suggest("pl", "wh", "wr", "st", "sc", "wh");
+	
+	// sc's next suggestion, best five first.
+	SuggestAdvisor advisor(&cr, std::thread::hardware_concurrency());
+	vector<SuggestionScore> scores = advisor.Rank();
+	for (int i = 0; i < 5 && i < (int) scores.size(); i++)
+		cout<<cards[scores[i].cards[0]]<<" "<<cards[scores[i].cards[1]]<<" "<<cards[scores[i].cards[2]]<<"\t"
+			<<scores[i].expected_cells<<" cells, "<<scores[i].num_outcomes<<" outcomes"<<endl;
+}
+
 int main()
 {
 	//TestSatSolver();
+	//TestSolverBackends();
 	TestClueReasoner();	
+	//TestReplayLog();
+	//TestGameFarm();
+	//TestSuggestAdvisor();
 	return 0;
 }
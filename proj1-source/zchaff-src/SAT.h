@@ -239,6 +239,13 @@ void SAT_SetRandomness(SAT_Manager      mng,
 void SAT_SetRandSeed(SAT_Manager        mng,
                      int                seed);
 
+// set the verbosity of the solver's console output. The default, 0,
+// prints the progress line and the trailing newline of each run. A
+// negative value silences the solver completely, which is what you want
+// when it is embedded in another program.
+void SAT_SetVerbosity(SAT_Manager       mng,
+                      int               n);
+
 // add a hookfunction. This function will be called
 // every "interval" of decisions. You can add more than
 // one such hook functions. i.e. call SAT_AddHookFun more
@@ -322,6 +329,12 @@ int SAT_Random_Seed(SAT_Manager mng);
 
 long64 SAT_NumImplications(SAT_Manager mng);
 
+// Watch list entries visited during BCP, and how many of them were skipped
+// because the clause's blocker literal was already true.
+long64 SAT_NumWatchVisits(SAT_Manager mng);
+
+long64 SAT_NumBlockerHits(SAT_Manager mng);
+
 int SAT_MaxDLevel(SAT_Manager mng);
 
 float SAT_AverageBubbleMove(SAT_Manager mng);
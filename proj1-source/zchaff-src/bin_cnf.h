@@ -0,0 +1,39 @@
+#ifndef __BIN_CNF__
+#define __BIN_CNF__
+
+// /*============================================================
+//
+// Binary CNF format, read by "zchaff -bin file".
+//
+// It carries the same information as a DIMACS file, but can be
+// written straight into a shared memory region (e.g. a memfd) by
+// the caller and mapped by the solver, with no text formatting or
+// parsing on either side. Every field is a native-endian 32 bit
+// integer:
+//
+//   BinCnfHeader { magic, version, num_vars, num_clauses, num_lits }
+//   then num_lits + num_clauses literals: each clause is its DIMACS
+//   literals (v or -v) followed by a 0 terminator.
+//
+// As with DIMACS files, repeated literals are merged and
+// tautological clauses are dropped by the reader.
+//
+// =============================================================*/
+
+#define BIN_CNF_MAGIC   0x464e4342      // "BCNF" read as little-endian
+#define BIN_CNF_VERSION 1
+
+struct BinCnfHeader {
+  int magic;
+  int version;
+  int num_vars;
+  int num_clauses;
+  int num_lits;
+};
+
+// total size in bytes of a binary CNF with the given counts
+inline long bin_cnf_size(int num_clauses, int num_lits) {
+  return sizeof(BinCnfHeader) + sizeof(int) * ((long)num_clauses + num_lits);
+}
+
+#endif
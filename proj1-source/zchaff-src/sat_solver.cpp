@@ -42,8 +42,14 @@
 
 #include <set>
 #include <vector>
+#include <algorithm>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "SAT.h"
+#include "bin_cnf.h"
 
 using namespace std;
 
@@ -144,6 +150,65 @@ void read_cnf(SAT_Manager mng, char * filename )
 }
 
 
+// Reads the binary format described in bin_cnf.h. The file is mapped
+// rather than read, so a caller can hand over a shared memory region
+// (e.g. /dev/fd/N of an inherited memfd) without any copying. Returns false
+// if the file holds an empty clause, which the library cannot take.
+bool read_bin_cnf(SAT_Manager mng, char * filename )
+{
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        cerr << "Can't open input file" << endl;
+        exit(1);
+    }
+    if (st.st_size < (long)sizeof(BinCnfHeader)) {
+        cerr << "Binary CNF file is truncated" << endl;
+        exit(3);
+    }
+    void * region = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (region == MAP_FAILED) {
+        cerr << "Can't map input file" << endl;
+        exit(1);
+    }
+    const BinCnfHeader * header = (const BinCnfHeader *) region;
+    if (header->magic != BIN_CNF_MAGIC || header->version != BIN_CNF_VERSION ||
+        st.st_size < bin_cnf_size(header->num_clauses, header->num_lits)) {
+        cerr << "Not a binary CNF file, or wrong version" << endl;
+        exit(3);
+    }
+    SAT_SetNumVariables(mng, header->num_vars);
+
+    const int * lits = (const int *) (header + 1);
+    const int * end = lits + header->num_clauses + header->num_lits;
+    vector<int> temp;
+    bool has_empty_clause = false;
+    while (lits < end) {
+        temp.clear();
+        for (; lits < end && *lits != 0; ++lits)
+            temp.push_back((abs(*lits) << 1) + (*lits < 0));
+        if (lits == end) {
+            cerr << "Binary CNF file is truncated" << endl;
+            exit(3);
+        }
+        ++lits;
+        if (temp.size() == 0)
+            has_empty_clause = true;
+        // same clean-up as read_cnf: merge repeated literals, skip tautologies
+        sort(temp.begin(), temp.end());
+        temp.erase(unique(temp.begin(), temp.end()), temp.end());
+        bool tautology = false;
+        for (unsigned i = 1; i < temp.size(); ++i)
+            if ((temp[i] >> 1) == (temp[i-1] >> 1))
+                tautology = true;
+        if (temp.size() != 0 && !tautology)
+            SAT_AddClause(mng, & temp.begin()[0], temp.size() );
+    }
+    munmap(region, st.st_size);
+    close(fd);
+    return !has_empty_clause;
+}
+
 void handle_result(SAT_Manager mng, int outcome, char * filename )
 {
     string result = "UNKNOWN";
@@ -197,6 +262,9 @@ void handle_result(SAT_Manager mng, int outcome, char * filename )
     cout << "Added Conflict Literals\t\t\t\t" << SAT_NumAddedLiterals(mng) - SAT_InitNumLiterals(mng) << endl;
     cout << "Deleted (Total) Literals\t\t\t" << SAT_NumDeletedLiterals(mng) <<endl;
     cout << "Number of Implication\t\t\t\t" << SAT_NumImplications(mng)<< endl;
+    cout << "Watch Visits (Blocker Hits)\t\t\t" << SAT_NumWatchVisits(mng)
+         << " (" << SAT_NumBlockerHits(mng) * 100.0 / (SAT_NumWatchVisits(mng) ? SAT_NumWatchVisits(mng) : 1)
+         << "%)" << endl;
     //other statistics comes here
     cout << "Total Run Time\t\t\t\t\t" << SAT_GetCPUTime(mng) << endl;
 //    cout << "RESULT:\t" << filename << " " << result << " RunTime: " << SAT_GetCPUTime(mng)<< endl;
@@ -251,17 +319,28 @@ int main(int argc, char ** argv)
         cerr << "Z-Chaff: Accelerated SAT Solver from Princeton. " << endl;
         cerr << "Copyright 2000-2004, Princeton University." << endl << endl;;
         cerr << "Usage: "<< argv[0] << " cnf_file [time_limit]" << endl;
+        cerr << "       "<< argv[0] << " -bin bin_cnf_file [time_limit]" << endl;
         return 2;
     }
+    // "-bin file" reads the binary format of bin_cnf.h instead of DIMACS
+    bool binary = (strcmp(argv[1], "-bin") == 0);
+    if (binary) {
+        if (argc < 3) {
+            cerr << "-bin needs a file name" << endl;
+            return 2;
+        }
+        ++argv;
+        --argc;
+    }
     cout << "Z-Chaff Version: " << SAT_Version(mng) << endl;
     cout << "Solving " << argv[1] << " ......" << endl;
-    if (argc == 2) {
-        read_cnf (mng, argv[1] );
-    }
-    else {
+    bool has_empty_clause = false;
+    if (binary)
+        has_empty_clause = !read_bin_cnf (mng, argv[1] );
+    else
         read_cnf (mng, argv[1] );
+    if (argc > 2)
         SAT_SetTimeLimit(mng, atoi(argv[2]));
-    }
 
 /* if you want some statistics during the solving, uncomment following line */
 //    SAT_AddHookFun(mng,output_status, 5000);
@@ -274,7 +353,7 @@ int main(int argc, char ** argv)
 /* randomness may help sometimes, by default, there is no randomness */
 //    SAT_SetRandomness (mng, 10);
 //    SAT_SetRandSeed (mng, -1);
-    int result = SAT_Solve(mng);
+    int result = (has_empty_clause ? UNSATISFIABLE : SAT_Solve(mng));
     if (result == SATISFIABLE) 
         verify_solution(mng);
     handle_result (mng, result,  argv[1]);
@@ -42,8 +42,6 @@ using namespace std;
 
 void CLitPoolElement::dump(ostream & os) {
   os << (var_sign() ? " -" : " +") << var_index();
-  if (is_watched())
-    os << "*";
 }
 
 void CClause::dump(ostream & os) {
@@ -56,23 +54,19 @@ void CClause::dump(ostream & os) {
 
 bool CClause::self_check(void) {
   assert(num_lits() > 0);
-  int watched = 0;
-  for (unsigned i = 0; i < num_lits(); ++i) {
+  for (unsigned i = 0; i < num_lits(); ++i)
     assert(literal(i).is_literal());
-    if (literal(i).is_watched())
-      ++watched;
-  }
-  assert(num_lits() ==1 || watched == 2);  // either unit, or have two watched
-  assert(!literal(num_lits() + 1).is_literal());
+  assert(!literal(num_lits()).is_literal());
   return true;
 }
 
 bool CVariable::self_check(void) {
   for (unsigned i = 0; i < 2; ++i) {
-    vector<CLitPoolElement*>& w = watched(i);
+    vector<CWatch>& w = watched(i);
     for (unsigned j = 0; j < w.size(); ++j) {
-      assert(w[j]->is_watched());
-      assert((unsigned)w[j]->var_sign() == i);
+      // a watched literal sits in one of the first two slots
+      assert(w[j].lits[0].var_sign() == i || w[j].lits[1].var_sign() == i);
+      assert(w[j].lits[2].is_literal());
     }
   }
   return true;
@@ -86,7 +80,7 @@ void CVariable::dump(ostream & os) {
   for (unsigned j = 0; j < 2; ++j) {
     os << (j == 0 ? "WPos " : "WNeg ") <<  "(" ;
     for (unsigned i = 0; i < watched(j).size(); ++i)
-      os << watched(j)[i]->find_clause_index() << "  " ;
+      os << watched(j)[i].lits->find_clause_index() << "  " ;
     os << ")" << endl;
   }
 #ifdef KEEP_LIT_CLAUSES
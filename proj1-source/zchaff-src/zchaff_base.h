@@ -66,17 +66,15 @@ enum CLAUSE_STATUS {
 //   Description [A literal is a variable with phase. Two things specify a
 //                literal: its "sign", and its variable index.
 //
-//                Each clause that has more than 1 literal contains two special
-//                literals. They are being "watched". A literal is marked with
-//                2 bits: 00->not watched; 11->watched, direction = 1;
-//                01->watched, dir = -1; 10 is not valid. These two bits occupy
-//                the least significant bits of the literal.
+//                Each clause that has more than 2 literals contains two special
+//                literals. They are being "watched", and they are always the
+//                first two literals of the clause (see CWatch).
 //
 //                Each literal is represented by a 32 bit signed integer. The
-//                higher 29 bits represent the variable index. At most 2**28
+//                higher 31 bits represent the variable index. At most 2**30
 //                varialbes are allowed. If the sign of this integer is
 //                negative, it means that it is not a valid literal. It could
-//                be a clause index or a deleted literal pool element. The 3rd
+//                be a clause index or a deleted literal pool element. The
 //                least significant bit is used to mark its sign.
 //                0->positive, 1->negative.
 //
@@ -110,40 +108,23 @@ class CLitPoolElement {
 
     // stands for signed variable, i.e. 2*var_idx + sign
     int s_var(void) {
-      return _val >> 2;
+      return _val;
     }
 
     unsigned var_index(void) {
-      return _val >> 3;
+      return _val >> 1;
     }
 
     unsigned var_sign(void) {
-      return ((_val >> 2) & 0x1);
+      return (_val & 0x1);
     }
 
     void set(int s_var) {
-      _val = (s_var << 2);
+      _val = s_var;
     }
 
     void set(int vid, int sign) {
-      _val = (((vid << 1) + sign) << 2);
-    }
-
-    // followings are for manipulate watched literals
-    int direction(void) {
-      return ((_val & 0x3) - 2);
-    }
-
-    bool is_watched(void) {
-      return ((_val & 0x3) != 0);
-    }
-
-    void unwatch(void) {
-      _val = _val & (~0x3);
-    }
-
-    void set_watch(int dir) {
-      _val = _val + dir + 2;
+      _val = (vid << 1) + sign;
     }
 
     // following are used for spacing (e.g. indicate clause's end)
@@ -176,6 +157,53 @@ class CLitPoolElement {
     }
 };
 
+// /**Class********************************************************************
+//
+//   Synopsis    [Entry of a variable's watch list]
+//
+//   Description [A clause with more than 2 literals keeps its two watched
+//                literals in its first two slots, and each of them lists the
+//                clause by the address of its first literal in the literal
+//                pool. BCP finds the other watch in the other slot, so a visit
+//                reads no more than these two literals unless the watch has
+//                to move or the clause is unit; then it scans the rest of the
+//                clause once, up to the spacing element that holds the clause
+//                index. A moved watch swaps places with its replacement.
+//
+//                The entry also holds a blocker: the signed variable
+//                (2*var_idx + sign) of some other literal of the same clause.
+//                When BCP visits the entry and the blocker is true, the
+//                clause is satisfied and can be skipped without touching the
+//                literal pool. Any literal of the clause is a correct blocker;
+//                the other watched literal is the one most likely to be true.]
+//
+// ****************************************************************************
+struct CWatch {
+  CLitPoolElement * lits;   // the clause's first literal
+  int blocker;
+
+  CWatch(CLitPoolElement * l, int b) : lits(l), blocker(b) {}
+};
+
+// /**Class********************************************************************
+//
+//   Synopsis    [Entry of a variable's binary clause list]
+//
+//   Description [Two-literal clauses are not watched. Each of their literals
+//                lists the clause together with the other literal, so when
+//                one literal becomes false BCP can imply (or find in
+//                conflict) the other directly. The clause still sits in the
+//                literal pool and is the antecedent of the implication, so
+//                conflict analysis and clause deletion see no difference.]
+//
+// ****************************************************************************
+struct CBinary {
+  int other;          // signed variable of the other literal
+  ClauseIdx cl_idx;
+
+  CBinary(int o, ClauseIdx c) : other(o), cl_idx(c) {}
+};
+
 // /**Class********************************************************************
 //
 //   Synopsis    [Definition of a clause]
@@ -343,8 +371,9 @@ class CVariable {
                               // variable. (two phases)
     int _2_lits_count[2];     // how many literals in 2 literal clauses are
                               // there with this variable. (two phases)
-    vector<CLitPoolElement *> _watched[2];  // watched literals of this
-                                            // var. 0: pos phase, 1: neg phase
+    vector<CWatch> _watched[2];  // watched literals of this var.
+                                 // 0: pos phase, 1: neg phase
+    vector<CBinary> _binaries[2];  // binary clauses of this var, same phases
 
 #ifdef KEEP_LIT_CLAUSES
     vector<ClauseIdx> _lit_clauses[2];  // this will keep track of ALL the
@@ -471,10 +500,14 @@ class CVariable {
       _antecedent = cl;
     }
 
-    inline vector<CLitPoolElement *> & watched(int i) {
+    inline vector<CWatch> & watched(int i) {
       return _watched[i];
     }
 
+    inline vector<CBinary> & binaries(int i) {
+      return _binaries[i];
+    }
+
     inline void enable_branch(void) {
       _enable_branch = true;
     }
@@ -172,6 +172,12 @@ extern "C" void SAT_SetRandSeed(SAT_Manager         mng,
   solver->set_random_seed(seed);
 }
 
+extern "C" void SAT_SetVerbosity(SAT_Manager         mng,
+                             int                 n) {
+  CSolver * solver = (CSolver*) mng;
+  solver->set_verbosity(n);
+}
+
 extern "C" int SAT_GetVarAsgnment(SAT_Manager       mng,
                               int               v_idx) {
   CSolver * solver = (CSolver*) mng;
@@ -305,6 +311,18 @@ extern "C" long64 SAT_NumImplications(SAT_Manager mng) {
   return n;
 }
 
+extern "C" long64 SAT_NumWatchVisits(SAT_Manager mng) {
+  CSolver * solver = (CSolver*) mng;
+  long64 n = solver->num_watch_visits();
+  return n;
+}
+
+extern "C" long64 SAT_NumBlockerHits(SAT_Manager mng) {
+  CSolver * solver = (CSolver*) mng;
+  long64 n = solver->num_blocker_hits();
+  return n;
+}
+
 extern "C" int SAT_MaxDLevel(SAT_Manager mng) {
   CSolver * solver = (CSolver*) mng;
   int n = solver->max_dlevel();
@@ -172,6 +172,12 @@ using namespace std;
   solver->set_random_seed(seed);
 }
 
+ void SAT_SetVerbosity(SAT_Manager         mng,
+                             int                 n) {
+  CSolver * solver = (CSolver*) mng;
+  solver->set_verbosity(n);
+}
+
  int SAT_GetVarAsgnment(SAT_Manager       mng,
                               int               v_idx) {
   CSolver * solver = (CSolver*) mng;
@@ -305,6 +311,18 @@ using namespace std;
   return n;
 }
 
+ long64 SAT_NumWatchVisits(SAT_Manager mng) {
+  CSolver * solver = (CSolver*) mng;
+  long64 n = solver->num_watch_visits();
+  return n;
+}
+
+ long64 SAT_NumBlockerHits(SAT_Manager mng) {
+  CSolver * solver = (CSolver*) mng;
+  long64 n = solver->num_blocker_hits();
+  return n;
+}
+
  int SAT_MaxDLevel(SAT_Manager mng) {
   CSolver * solver = (CSolver*) mng;
   int n = solver->max_dlevel();
@@ -34,6 +34,7 @@
 // ********************************************************************/
 
 #include <cstdlib>
+#include <stdint.h>
 
 #include <iostream>
 #include <vector>
@@ -55,12 +56,14 @@ CDatabase::CDatabase(void) {
   _stats.num_enlarge                 = 0;
   _stats.num_compact                 = 0;
   _lit_pool_start = (CLitPoolElement *) malloc(sizeof(CLitPoolElement) *
-                                               STARTUP_LIT_POOL_SIZE);
+                                               (STARTUP_LIT_POOL_SIZE +
+                                                LIT_POOL_PADDING));
   _lit_pool_finish = _lit_pool_start;
   _lit_pool_end_storage = _lit_pool_start + STARTUP_LIT_POOL_SIZE;
   lit_pool_push_back(0);  // set the first element as a dummy element
   _params.mem_limit = 1024 * 1024 * 1024;  // that's 1 G
   variables()->resize(1);                  // var_id == 0 is never used.
+  _lit_values.resize(2, UNKNOWN);
   _allocated_gid                    = 0;
 }
 
@@ -74,7 +77,7 @@ unsigned CDatabase::estimate_mem_usage(void) {
   unsigned mem_vars = sizeof(CVariable) * variables()->capacity();
   unsigned mem_cls = sizeof(CClause) * clauses()->capacity();
   unsigned mem_cls_queue = sizeof(int) * _unused_clause_idx.size();
-  unsigned mem_watched = 2 * num_clauses() * sizeof(CLitPoolElement *);
+  unsigned mem_watched = 2 * num_clauses() * sizeof(CWatch);
   unsigned mem_lit_clauses = 0;
 #ifdef KEEP_LIT_CLAUSES
   mem_lit_clauses = num_literals() * sizeof(ClauseIdx);
@@ -89,18 +92,21 @@ unsigned CDatabase::mem_usage(void) {
   int mem_vars = sizeof(CVariable) * variables()->capacity();
   int mem_cls = sizeof(CClause) * clauses()->capacity();
   int mem_cls_queue = sizeof(int) * _unused_clause_idx.size();
-  int mem_watched = 0, mem_lit_clauses = 0;
+  int mem_watched = 0, mem_binaries = 0, mem_lit_clauses = 0;
   for (unsigned i = 0, sz = variables()->size(); i < sz ;  ++i) {
     CVariable & v = variable(i);
     mem_watched        += v.watched(0).capacity() + v.watched(1).capacity();
+    mem_binaries       += v.binaries(0).capacity() + v.binaries(1).capacity();
 #ifdef KEEP_LIT_CLAUSES
     mem_lit_clauses += v.lit_clause(0).capacity() + v.lit_clause(1).capacity();
 #endif
   }
-  mem_watched *= sizeof(CLitPoolElement*);
+  mem_watched *= sizeof(CWatch);
+  mem_binaries *= sizeof(CBinary);
   mem_lit_clauses *= sizeof(ClauseIdx);
-  return (mem_lit_pool + mem_vars + mem_cls +
-          mem_cls_queue + mem_watched + mem_lit_clauses);
+  int mem_lit_values = sizeof(int32) * _lit_values.capacity();
+  return (mem_lit_pool + mem_vars + mem_cls + mem_cls_queue +
+          mem_watched + mem_binaries + mem_lit_clauses + mem_lit_values);
 }
 
 int CDatabase::alloc_gid(void) {
@@ -269,22 +275,32 @@ void CDatabase::compact_lit_pool(void) {
   }
   for (i = 1, sz = lit_pool_size(); i < sz;  ++i) {
     CLitPoolElement & lit = lit_pool(i);
-    // 2. reinsert the watched pointers
-    if (lit.is_literal()) {
-      if (lit.is_watched()) {
-         int var_idx = lit.var_index();
-         int sign = lit.var_sign();
-         variable(var_idx).watched(sign).push_back(& lit_pool(i));
-       }
-    } else {  // lit is not literal
-    // 3. update the clauses' first literal pointer
+    if (!lit.is_literal()) {
+    // 2. update the clauses' first literal pointer
       int cls_idx = lit.get_clause_index();
-      clause(cls_idx).first_lit() = &lit_pool(i) - clause(cls_idx).num_lits();
+      CClause & cl = clause(cls_idx);
+      cl.first_lit() = &lit_pool(i) - cl.num_lits();
+    // 3. reinsert the watched pointers, each blocked by the other watch
+      if (cl.num_lits() > 2) {
+        CLitPoolElement & w0 = cl.literal(0), & w1 = cl.literal(1);
+        variable(w0.var_index()).watched(w0.var_sign()).push_back(
+            CWatch(cl.literals(), w1.s_var()));
+        variable(w1.var_index()).watched(w1.var_sign()).push_back(
+            CWatch(cl.literals(), w0.s_var()));
+      }
     }
   }
   ++_stats.num_compact;
 }
 
+// The pointer into 'new_start' at the same offset as 'lit' had into the
+// pool that started at 'old_start'.
+static CLitPoolElement * rebase_lit(CLitPoolElement * lit, uintptr_t old_start,
+                                    CLitPoolElement * new_start) {
+  return new_start + (reinterpret_cast<uintptr_t>(lit) - old_start) /
+                     sizeof(CLitPoolElement);
+}
+
 bool CDatabase::enlarge_lit_pool(void) {
   // will return true if successful, otherwise false.
   unsigned i, sz;
@@ -311,30 +327,36 @@ bool CDatabase::enlarge_lit_pool(void) {
     else
       return false;
   }
-  // second, make room for new lit pool.
-  CLitPoolElement * old_start = _lit_pool_start;
-  CLitPoolElement * old_finish = _lit_pool_finish;
+  // second, make room for new lit pool. realloc frees the old pool, so its
+  // address is kept as an integer, and the pointers into it are only read
+  // as integers from then on.
+  uintptr_t old_start = reinterpret_cast<uintptr_t>(_lit_pool_start);
+  int old_num_lits = _lit_pool_finish - _lit_pool_start;
   int old_size = _lit_pool_end_storage - _lit_pool_start;
   int new_size = (int)(old_size * grow_ratio);
   _lit_pool_start = (CLitPoolElement *) realloc(_lit_pool_start,
                                                 sizeof(CLitPoolElement) *
-                                                new_size);
-  _lit_pool_finish = _lit_pool_start + (old_finish - old_start);
+                                                (new_size + LIT_POOL_PADDING));
+  _lit_pool_finish = _lit_pool_start + old_num_lits;
   _lit_pool_end_storage = _lit_pool_start + new_size;
 
-  // update all the pointers
-  int displacement = _lit_pool_start - old_start;
+  // update all the pointers. Rebase each one by its offset into the old
+  // pool: the distance between the old and the new block need not fit in
+  // an int on 64-bit hosts (e.g. when realloc moves the pool to an mmap'ed
+  // region).
   for (i = 0; i < clauses()->size(); ++i) {
     if (clause(i).status() != DELETED_CL)
-      clause(i).first_lit() += displacement;
+      clause(i).first_lit() = rebase_lit(clause(i).first_lit(), old_start,
+                                         _lit_pool_start);
   }
   for (i = 0, sz = variables()->size(); i < sz ;  ++i) {
     CVariable & v = variable(i);
     for (int j = 0; j < 2 ; ++j) {
       int k, sz1;
-      vector<CLitPoolElement *> & watched = v.watched(j);
+      vector<CWatch> & watched = v.watched(j);
       for (k = 0, sz1 = watched.size(); k < sz1 ; ++k) {
-        watched[k] += displacement;
+        watched[k].lits = rebase_lit(watched[k].lits, old_start,
+                                     _lit_pool_start);
       }
     }
   }
@@ -380,19 +402,23 @@ ClauseIdx CDatabase::add_clause(int * lits, int n_lits, int gflag) {
   }
   // the element after the last one is the spacing element
   cl.literal(n_lits).set_clause_index(new_cl);
-  // d. set the watched pointers
-  if (cl.num_lits() > 1) {
+  // d. set the watched pointers, or the binary lists for a two-literal clause
+  if (cl.num_lits() == 2) {
+    CLitPoolElement & l0 = cl.literal(0), & l1 = cl.literal(1);
+    variable(l0.var_index()).binaries(l0.var_sign()).push_back(
+        CBinary(l1.s_var(), new_cl));
+    variable(l1.var_index()).binaries(l1.var_sign()).push_back(
+        CBinary(l0.s_var(), new_cl));
+  } else if (cl.num_lits() > 1) {
     // add the watched literal. note: watched literal must be the last free var
     int max_idx = -1, max_dl = -1;
+    int first = -1, second = -1;
     int i, sz = cl.num_lits();
-    // set the first watched literal
+    // choose the first watched literal
     for (i = 0; i < sz; ++i) {
-      int v_idx = cl.literal(i).var_index();
-      int v_sign = cl.literal(i).var_sign();
-      CVariable & v = variable(v_idx);
+      CVariable & v = variable(cl.literal(i).var_index());
       if (literal_value(cl.literal(i)) != 0) {
-        v.watched(v_sign).push_back(&cl.literal(i));
-        cl.literal(i).set_watch(1);
+        first = i;
         break;
       } else {
         if (v.dlevel() > max_dl) {
@@ -401,25 +427,18 @@ ClauseIdx CDatabase::add_clause(int * lits, int n_lits, int gflag) {
         }
       }
     }
-    if (i >= sz) {  // no unassigned literal. so watch literal with max dlevel
-      int v_idx = cl.literal(max_idx).var_index();
-      int v_sign = cl.literal(max_idx).var_sign();
-      variable(v_idx).watched(v_sign).push_back(&cl.literal(max_idx));
-      cl.literal(max_idx).set_watch(1);
-    }
+    if (i >= sz)  // no unassigned literal. so watch literal with max dlevel
+      first = max_idx;
 
-    // set the second watched literal
+    // choose the second watched literal
     max_idx = -1;
     max_dl = -1;
     for (i = sz-1; i >= 0; --i) {
-      if (cl.literal(i).is_watched())
+      if (i == first)
         continue;  // need to watch two different literals
-      int v_idx = cl.literal(i).var_index();
-      int v_sign = cl.literal(i).var_sign();
-      CVariable & v = variable(v_idx);
+      CVariable & v = variable(cl.literal(i).var_index());
       if (literal_value(cl.literal(i)) != 0) {
-        v.watched(v_sign).push_back(&cl.literal(i));
-        cl.literal(i).set_watch(-1);
+        second = i;
         break;
       } else {
         if (v.dlevel() > max_dl) {
@@ -428,12 +447,23 @@ ClauseIdx CDatabase::add_clause(int * lits, int n_lits, int gflag) {
         }
       }
     }
-    if (i < 0) {
-      int v_idx = cl.literal(max_idx).var_index();
-      int v_sign = cl.literal(max_idx).var_sign();
-      variable(v_idx).watched(v_sign).push_back(&cl.literal(max_idx));
-      cl.literal(max_idx).set_watch(-1);
-    }
+    if (i < 0)
+      second = max_idx;
+
+    // move them to the watched slots 0 and 1, each blocked by the other
+    CLitPoolElement tmp = cl.literal(0);
+    cl.literal(0) = cl.literal(first);
+    cl.literal(first) = tmp;
+    if (second == 0)
+      second = first;
+    tmp = cl.literal(1);
+    cl.literal(1) = cl.literal(second);
+    cl.literal(second) = tmp;
+    CLitPoolElement & w0 = cl.literal(0), & w1 = cl.literal(1);
+    variable(w0.var_index()).watched(w0.var_sign()).push_back(
+        CWatch(cl.literals(), w1.s_var()));
+    variable(w1.var_index()).watched(w1.var_sign()).push_back(
+        CWatch(cl.literals(), w0.s_var()));
   }
   // update some statistics
   ++_stats.num_added_clauses;
@@ -38,6 +38,9 @@
 #include "zchaff_base.h"
 
 #define STARTUP_LIT_POOL_SIZE 0x8000
+// elements allocated past the storage end of the lit pool, so that a block
+// scan of a clause may read a whole block beyond its spacing element
+#define LIT_POOL_PADDING 8
 
 // **Struct********************************************************************
 //
@@ -104,6 +107,9 @@ class CDatabase {
 
     vector<CVariable>   _variables;     // note: first element is not used
 
+    vector<int32>       _lit_values;    // svar_value() of every literal,
+                                        // stored densely for the BCP scan
+
     vector<CClause>     _clauses;
 
     set<ClauseIdx>      _unused_clause_idx;
@@ -162,6 +168,15 @@ class CDatabase {
       return (variable(svar >> 1).value() ^ (svar & 0x1));
     }
 
+    int32 * lit_values(void) {
+      return &_lit_values[0];
+    }
+
+    void set_lit_values(int vid, unsigned value) {
+      _lit_values[vid + vid] = value;
+      _lit_values[vid + vid + 1] = (value == UNKNOWN ? UNKNOWN : value ^ 1);
+    }
+
     // clause properties
     void mark_clause_deleted(CClause & cl);
 
@@ -278,10 +293,12 @@ class CDatabase {
 
     inline void set_variable_number(int n) {
       variables()->resize(n + 1);
+      _lit_values.resize(2 * (n + 1), UNKNOWN);
     }
 
     inline int add_variable(void) {
       variables()->resize(variables()->size() + 1);
+      _lit_values.resize(2 * variables()->size(), UNKNOWN);
       return variables()->size() - 1;
     }
 
@@ -45,6 +45,75 @@ using namespace std;
 
 #include "zchaff_solver.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(DISABLE_SIMD)
+#define ZCHAFF_AVX2
+#include <immintrin.h>
+#endif
+
+// find the first literal that is not false, starting at ptr; used by BCP to
+// look for a replacement watch. values is the dense per-literal value array
+// (see CDatabase::lit_values). Returns the clause's spacing element if all
+// the literals are false. The AVX2 version is picked at startup when the
+// CPU has it.
+typedef CLitPoolElement * (*FindNonFalseFunT)(CLitPoolElement * ptr,
+                                              const int32 * values);
+
+static CLitPoolElement * find_non_false_scalar(CLitPoolElement * ptr,
+                                               const int32 * values) {
+  for (; ptr->is_literal(); ++ptr) {
+    if (values[ptr->s_var()] != 0)
+      break;
+  }
+  return ptr;
+}
+
+#ifdef ZCHAFF_AVX2
+// a replacement is usually among the first few literals, which are checked
+// one by one as a gather costs more than that. Past them, 8 pool elements
+// at a time: the literals are gathered from values, and the first lane that
+// is either a non-false literal or a spacing element (val <= 0) ends the
+// scan. Lanes past a spacing element are left out of the gather, since they
+// may hold garbage; the pool is padded so the load itself never leaves the
+// allocation.
+__attribute__((target("avx2")))
+static CLitPoolElement * find_non_false_avx2(CLitPoolElement * ptr,
+                                             const int32 * values) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  for (CLitPoolElement * head_end = ptr + 4; ptr < head_end; ++ptr) {
+    if (!ptr->is_literal() || values[ptr->s_var()] != 0)
+      return ptr;
+  }
+  for (;; ptr += 8) {
+    __m256i lits = _mm256_loadu_si256((const __m256i *) ptr);
+    unsigned spacing = _mm256_movemask_ps(_mm256_castsi256_ps(
+        _mm256_cmpgt_epi32(one, lits)));
+    int num_lits = (spacing ? __builtin_ctz(spacing) : 8);
+    __m256i live = _mm256_cmpgt_epi32(_mm256_set1_epi32(num_lits), lane);
+    __m256i vals = _mm256_mask_i32gather_epi32(zero, (const int *) values,
+                                               lits, live, 4);
+    unsigned non_false = ~_mm256_movemask_ps(_mm256_castsi256_ps(
+        _mm256_cmpeq_epi32(vals, zero))) & 0xff;
+    unsigned stop = non_false | spacing;
+    if (stop)
+      return ptr + __builtin_ctz(stop);
+  }
+}
+#endif
+
+static FindNonFalseFunT select_find_non_false(void) {
+#ifdef ZCHAFF_AVX2
+  __builtin_cpu_init();  // we may run before the runtime's own constructor
+  if (__builtin_cpu_supports("avx2"))
+    return find_non_false_avx2;
+#endif
+  return find_non_false_scalar;
+}
+
+static const FindNonFalseFunT find_non_false = select_find_non_false();
+
 // #define VERIFY_ON
 
 #ifdef VERIFY_ON
@@ -68,6 +137,8 @@ void CSolver::re_init_stats(void) {
   _stats.num_backtracks               = 0;
   _stats.max_dlevel                   = 0;
   _stats.num_implications             = 0;
+  _stats.num_watch_visits             = 0;
+  _stats.num_blocker_hits             = 0;
   _stats.num_restarts                 = 0;
   _stats.num_del_orig_cls             = 0;
   _stats.num_shrinkings               = 0;
@@ -118,6 +189,7 @@ CSolver::CSolver(void) {
   init_parameters();
   init_stats();
   _dlevel                       = 0;
+  _qhead                        = 0;
   _force_terminate              = false;
   _implication_id               = 0;
   _num_marked                   = 0;
@@ -127,10 +199,6 @@ CSolver::CSolver(void) {
 }
 
 CSolver::~CSolver(void) {
-  while (!_assignment_stack.empty()) {
-    delete _assignment_stack.back();
-    _assignment_stack.pop_back();
-  }
 }
 
 void CSolver::set_time_limit(float t) {
@@ -149,17 +217,15 @@ void CSolver::set_variable_number(int n) {
   assert(num_variables() == 0);
   CDatabase::set_variable_number(n);
   _stats.num_free_variables = num_variables();
-  while (_assignment_stack.size() <= num_variables())
-    _assignment_stack.push_back(new vector<int>);
-  assert(_assignment_stack.size() == num_variables() + 1);
+  _trail.reserve(num_variables() + 1);
+  _level_start.reserve(num_variables() + 2);
 }
 
 int CSolver::add_variable(void) {
   int num = CDatabase::add_variable();
   ++_stats.num_free_variables;
-  while (_assignment_stack.size() <= num_variables())
-    _assignment_stack.push_back(new vector<int>);
-  assert(_assignment_stack.size() == num_variables() + 1);
+  _trail.reserve(num_variables() + 1);
+  _level_start.reserve(num_variables() + 2);
   return num;
 }
 
@@ -175,6 +241,10 @@ void CSolver::set_random_seed(int seed) {
   srand(seed);
 }
 
+void CSolver::set_verbosity(int n) {
+  _params.verbosity = n;
+}
+
 void CSolver::enable_cls_deletion(bool allow) {
   _params.cls_deletion.enable = allow;
 }
@@ -193,9 +263,10 @@ void CSolver::run_periodic_functions(void) {
     restart();
     if (_stats.num_restarts % 5 == 1)
       compact_lit_pool();
-    cout << "\rDecision: " << _assignment_stack[0]->size() << "/"
-         <<num_variables() << "\tTime: " << get_cpu_time() -
-           _stats.start_cpu_time << "/" << _params.time_limit << flush;
+    if (_params.verbosity >= 0)
+      cout << "\rDecision: " << num_assigned_at(0) << "/"
+           <<num_variables() << "\tTime: " << get_cpu_time() -
+             _stats.start_cpu_time << "/" << _params.time_limit << flush;
   }
 
   // b. decay variable score
@@ -251,9 +322,12 @@ void CSolver::set_var_value(int v, int value, ClauseIdx ante, int dl) {
 
     var.set_dlevel(dl);
     var.set_value(value);
+    set_lit_values(v, value);
     var.antecedent() = ante;
-    var.assgn_stack_pos() = _assignment_stack[dl]->size();
-    _assignment_stack[dl]->push_back(v * 2 + !value);
+    while (_level_start.size() <= (unsigned)dl)
+      _level_start.push_back(_trail.size());
+    var.assgn_stack_pos() = _trail.size();
+    _trail.push_back(v * 2 + !value);
     set_var_value_BCP(v, value);
 
     ++_stats.num_implications ;
@@ -262,50 +336,59 @@ void CSolver::set_var_value(int v, int value, ClauseIdx ante, int dl) {
 }
 
 void CSolver::set_var_value_BCP(int v, int value) {
-  vector<CLitPoolElement *> & watchs = variable(v).watched(value);
-  for (vector <CLitPoolElement *>::iterator itr = watchs.begin();
+  // binary clauses first: the other literal is implied right away
+  vector<CBinary> & binaries = variable(v).binaries(value);
+  for (vector<CBinary>::iterator itr = binaries.begin();
+       itr != binaries.end(); ++itr) {
+    int the_value = svar_value(itr->other);
+    if (the_value == 0)  // a conflict
+      _conflicts.push_back(itr->cl_idx);
+    else if (the_value != 1)  // i.e. unknown
+      queue_implication(itr->other, itr->cl_idx);
+  }
+
+  vector<CWatch> & watchs = variable(v).watched(value);
+  int false_lit = v + v + value;
+  for (vector <CWatch>::iterator itr = watchs.begin();
        itr != watchs.end(); ++itr) {
-    ClauseIdx cl_idx;
-    CLitPoolElement * other_watched = *itr;
-    CLitPoolElement * watched = *itr;
-    int dir = watched->direction();
-    CLitPoolElement * ptr = watched;
-    while (true) {
-      ptr += dir;
-      if (ptr->val() <= 0) {  // reached one end of the clause
-        if (dir == 1)  // reached the right end, i.e. spacing element is cl_id
-          cl_idx = ptr->get_clause_index();
-        if (dir == watched->direction()) {  // we haven't go both directions.
-          ptr = watched;
-          dir = -dir;                     // change direction, go the other way
-          continue;
-        }
-        // otherwise, we have already go through the whole clause
-        int the_value = literal_value(*other_watched);
-        if (the_value == 0)  // a conflict
-          _conflicts.push_back(cl_idx);
-        else if (the_value != 1)  // i.e. unknown
-          queue_implication(other_watched->s_var(), cl_idx);
-        break;
-      }
-      if (ptr->is_watched()) {  // literal is the other watched lit, skip it.
-        other_watched = ptr;
-        continue;
-      }
-      if (literal_value(*ptr) == 0)  // literal value is 0, keep going
-        continue;
-      // now the literal's value is either 1 or unknown, watch it instead
-      int v1 = ptr->var_index();
-      int sign = ptr->var_sign();
-      variable(v1).watched(sign).push_back(ptr);
-      ptr->set_watch(dir);
+    ++_stats.num_watch_visits;
+    if (svar_value(itr->blocker) == 1) {  // satisfied, no need to look inside
+      ++_stats.num_blocker_hits;
+      continue;
+    }
+    CLitPoolElement * lits = itr->lits;
+    // the watches are in slots 0 and 1; find which one became false
+    int slot = (lits[0].s_var() == false_lit ? 0 : 1);
+    assert(lits[slot].s_var() == false_lit);
+    int other_watched = lits[1 - slot].s_var();
+    int the_value = svar_value(other_watched);
+    if (the_value == 1) {
+      // the clause is satisfied. the other watch was assigned no later
+      // than this literal, so it can block the next visit.
+      itr->blocker = other_watched;
+      continue;
+    }
+    CLitPoolElement * ptr = find_non_false(lits + 2, lit_values());
+    if (ptr->is_literal()) {
+      // the literal's value is either 1 or unknown, watch it instead
+      int new_watched = ptr->s_var();
+      lits[slot] = *ptr;
+      ptr->set(false_lit);
+      variable(new_watched >> 1).watched(new_watched & 0x1).push_back(
+          CWatch(lits, other_watched));
       // remove the original watched literal from watched list
-      watched->unwatch();
       *itr = watchs.back();  // copy the last element in it's place
       watchs.pop_back();     // remove the last element
       --itr;                 // do this so with don't skip one during traversal
-      break;
+      continue;
     }
+    // all the other literals are false. ptr is the spacing element now,
+    // which holds the clause index
+    ClauseIdx cl_idx = ptr->get_clause_index();
+    if (the_value == 0)  // a conflict
+      _conflicts.push_back(cl_idx);
+    else  // i.e. unknown
+      queue_implication(other_watched, cl_idx);
   }
 }
 
@@ -314,6 +397,7 @@ void CSolver::unset_var_value(int v) {
     return;
   CVariable & var = variable(v);
   var.set_value(UNKNOWN);
+  set_lit_values(v, UNKNOWN);
   var.set_antecedent(NULL_CLAUSE);
   var.set_dlevel(-1);
   var.assgn_stack_pos() = -1;
@@ -329,9 +413,9 @@ void CSolver::dump_assignment_stack(ostream & os ) {
   os << "Assignment Stack:  ";
   for (int i = 0; i <= dlevel(); ++i) {
     os << "(" <<i << ":";
-    for (unsigned j = 0; j < (*_assignment_stack[i]).size(); ++j) {
-      os << ((*_assignment_stack[i])[j]&0x1?"-":"+")
-         << ((*_assignment_stack[i])[j] >> 1) << " ";
+    for (int j = level_start(i); j < level_start(i + 1); ++j) {
+      os << (_trail[j]&0x1?"-":"+")
+         << (_trail[j] >> 1) << " ";
     }
     os << ") " << endl;
   }
@@ -339,7 +423,12 @@ void CSolver::dump_assignment_stack(ostream & os ) {
 }
 
 void CSolver::dump_implication_queue(ostream & os) {
-  _implication_queue.dump(os);
+  os << "Implication Queue Previous: " ;
+  for (unsigned i = _qhead; i < _implication_queue.size(); ++i) {
+    const CImplication & a = _implication_queue[i];
+    os << "(" << ((a.lit & 0x1) ? "-" : "+") << (a.lit >> 1)
+       << ":" << a.antecedent << ")  ";
+  }
 }
 
 void CSolver::delete_clause_group(int gid) {
@@ -375,15 +464,25 @@ void CSolver::delete_clause_group(int gid) {
       }
 #endif
       // delete the watched index from the vars
-      vector<CLitPoolElement *> & watched = (*itr).watched(i);
-      for (vector<CLitPoolElement *>::iterator itr1 = watched.begin();
+      vector<CWatch> & watched = (*itr).watched(i);
+      for (vector<CWatch>::iterator itr1 = watched.begin();
            itr1 != watched.end(); ++itr1) {
-        if ((*itr1)->val() <= 0) {
+        if (itr1->lits->val() <= 0) {
           *itr1 = watched.back();
           watched.pop_back();
           --itr1;
         }
       }
+      // delete the binary clauses from the vars
+      vector<CBinary> & binaries = (*itr).binaries(i);
+      for (vector<CBinary>::iterator itr1 = binaries.begin();
+           itr1 != binaries.end(); ++itr1) {
+        if (clause(itr1->cl_idx).status() == DELETED_CL) {
+          *itr1 = binaries.back();
+          binaries.pop_back();
+          --itr1;
+        }
+      }
     }
   }
   free_gid(gid);
@@ -396,8 +495,7 @@ void CSolver::reset(void) {
     return;
   back_track(0);
   _conflicts.clear();
-  while (!_implication_queue.empty())
-    _implication_queue.pop();
+  clear_implication_queue();
 
   _stats.outcome = UNDETERMINED;
   _stats.been_reset = true;
@@ -494,15 +592,25 @@ void CSolver::delete_unrelevant_clauses(void) {
       }
 #endif
       // delete the watched index from the vars
-      vector<CLitPoolElement *> & watched = (*itr).watched(i);
-      for (vector<CLitPoolElement *>::iterator itr1 = watched.begin();
+      vector<CWatch> & watched = (*itr).watched(i);
+      for (vector<CWatch>::iterator itr1 = watched.begin();
            itr1 != watched.end(); ++itr1) {
-        if ((*itr1)->val() <= 0) {
+        if (itr1->lits->val() <= 0) {
           *itr1 = watched.back();
           watched.pop_back();
           --itr1;
         }
       }
+      // delete the binary clauses from the vars
+      vector<CBinary> & binaries = (*itr).binaries(i);
+      for (vector<CBinary>::iterator itr1 = binaries.begin();
+           itr1 != binaries.end(); ++itr1) {
+        if (clause(itr1->cl_idx).status() == DELETED_CL) {
+          *itr1 = binaries.back();
+          binaries.pop_back();
+          --itr1;
+        }
+      }
     }
   }
 
@@ -580,13 +688,13 @@ void CSolver::decay_variable_score(void) {
 
 bool CSolver::decide_next_branch(void) {
   if (dlevel() > 0)
-    assert(_assignment_stack[dlevel()]->size() > 0);
-  if (!_implication_queue.empty()) {
+    assert(num_assigned_at(dlevel()) > 0);
+  if (!implication_queue_empty()) {
     // some hook function did a decision, so skip my own decision making.
     // if the front of implication queue is 0, that means it's finished
     // because var index start from 1, so 2 *vid + sign won't be 0.
     // else it's a valid decision.
-    return (_implication_queue.front().lit != 0);
+    return (_implication_queue[_qhead].lit != 0);
   }
   int s_var = 0;
   if (_params.shrinking.enable) {
@@ -606,8 +714,8 @@ bool CSolver::decide_next_branch(void) {
   if (_outside_constraint_hook != NULL)
      _outside_constraint_hook(this);
 
-  if (!_implication_queue.empty())
-     return (_implication_queue.front().lit != 0);
+  if (!implication_queue_empty())
+     return (_implication_queue[_qhead].lit != 0);
 
   ++_stats.num_decisions;
   if (num_free_variables() == 0)  // no more free vars
@@ -765,7 +873,8 @@ int CSolver::preprocess(void) {
   }
 
   if (deduce() == CONFLICT) {
-    cout << " CONFLICT during preprocess " <<endl;
+    if (_params.verbosity >= 0)
+      cout << " CONFLICT during preprocess " <<endl;
 #ifdef VERIFY_ON
     for (unsigned i = 1; i < variables()->size(); ++i) {
       if (variable(i).value() != UNKNOWN) {
@@ -795,7 +904,7 @@ int CSolver::preprocess(void) {
     return CONFLICT;
   }
   if (_params.verbosity > 1) {
-    cout << _assignment_stack[0]->size() << " vars set during preprocess; "
+    cout << num_assigned_at(0) << " vars set during preprocess; "
          << endl;
   }
   return NO_CONFLICT;
@@ -901,7 +1010,8 @@ int CSolver::solve(void) {
       _stats.outcome = UNSATISFIABLE;
     else  // the real search
       real_solve();
-    cout << endl;
+    if (_params.verbosity >= 0)
+      cout << endl;
     _stats.finish_cpu_time = get_cpu_time();
   }
   return _stats.outcome;
@@ -909,12 +1019,12 @@ int CSolver::solve(void) {
 
 void CSolver::back_track(int blevel) {
   assert(blevel <= dlevel());
-  for (int i = dlevel(); i >= blevel; --i) {
-    vector<int> & assignments = *_assignment_stack[i];
-    for (int j = assignments.size() - 1 ; j >= 0; --j)
-      unset_var_value(assignments[j]>>1);
-    assignments.clear();
-  }
+  int start = level_start(blevel);
+  for (int j = _trail.size() - 1; j >= start; --j)
+    unset_var_value(_trail[j]>>1);
+  _trail.resize(start);
+  if (_level_start.size() > (unsigned)blevel)
+    _level_start.resize(blevel);
   dlevel() = blevel - 1;
   if (dlevel() < 0 )
     dlevel() = 0;
@@ -922,12 +1032,12 @@ void CSolver::back_track(int blevel) {
 }
 
 int CSolver::deduce(void) {
-  while (!_implication_queue.empty()) {
-    const CImplication & imp = _implication_queue.front();
+  while (_qhead < _implication_queue.size()) {
+    // copy out: BCP below may grow (and move) the queue
+    const CImplication imp = _implication_queue[_qhead++];
     int lit = imp.lit;
     int vid = lit>>1;
     ClauseIdx cl = imp.antecedent;
-    _implication_queue.pop();
     CVariable & var = variable(vid);
     if (var.value() == UNKNOWN) {  // an implication
       set_var_value(vid, !(lit & 0x1), cl, dlevel());
@@ -951,18 +1061,19 @@ int CSolver::deduce(void) {
     }
   }
   // if loop exited because of a conflict, we need to clean implication queue
-  while (!_implication_queue.empty())
-    _implication_queue.pop();
+  clear_implication_queue();
   return (_conflicts.size() ? CONFLICT : NO_CONFLICT);
 }
 
 void CSolver::verify_integrity(void) {
   for (unsigned i = 1; i < variables()->size(); ++i) {
+    assert((unsigned)lit_values()[i + i] == variable(i).value());
     if (variable(i).value() != UNKNOWN) {
       int pos = variable(i).assgn_stack_pos();
       int value = variable(i).value();
       int dlevel = variable(i).dlevel();
-      assert((*_assignment_stack[dlevel])[pos] == (int) (i+i+1-value));
+      assert(_trail[pos] == (int) (i+i+1-value));
+      assert(pos >= level_start(dlevel) && pos < level_start(dlevel + 1));
     }
   }
   for (unsigned i = 0; i < clauses()->size(); ++i) {
@@ -972,9 +1083,6 @@ void CSolver::verify_integrity(void) {
     int num_0 = 0;
     int num_1 = 0;
     int num_unknown = 0;
-    int watched[2];
-    int watch_index = 0;
-    watched[1] = watched[0] = 0;
     for (unsigned j = 0; j < cl.num_lits(); ++j) {
       CLitPoolElement lit = cl.literal(j);
       int vid = lit.var_index();
@@ -986,33 +1094,31 @@ void CSolver::verify_integrity(void) {
         else
           ++num_1;
       }
-      if (lit.is_watched()) {
-        watched[watch_index] = lit.s_var();
-        ++watch_index;
-      }
     }
-    if (watch_index == 0) {
-      assert(cl.num_lits() == 1);
-      continue;
-    }
-    assert(watch_index == 2);
-    for (unsigned j = 0; j < cl.num_lits(); ++j) {
-      CLitPoolElement lit = cl.literal(j);
-      int vid1 = (watched[0]>>1);
-      if (variable(vid1).value() == (unsigned)(watched[0] & 0x1)) {
-        if (!lit.is_watched()) {
-          assert(literal_value(lit) == 0);
-          assert(variable(lit.var_index()).dlevel() <=
-                  variable(vid1).dlevel());
-        }
+    if (cl.num_lits() <= 2)
+      continue;  // unit, or binary (see CBinary)
+    if (num_1 > 0)
+      continue;  // a false watch may stay put while the other watch is true
+    // the watched literals are the first two; if one of them is false, so
+    // are all the unwatched ones, and no later than it
+    for (unsigned w = 0; w < 2; ++w) {
+      if (literal_value(cl.literal(w)) != 0)
+        continue;
+      int dl = variable(cl.literal(w).var_index()).dlevel();
+      for (unsigned j = 2; j < cl.num_lits(); ++j) {
+        assert(literal_value(cl.literal(j)) == 0);
+        assert(variable(cl.literal(j).var_index()).dlevel() <= dl);
       }
-      int vid2 = (watched[1]>>1);
-      if (variable(vid2).value() == (unsigned)(watched[1] & 0x1)) {
-        if (!lit.is_watched()) {
-          assert(literal_value(lit) == 0);
-          assert(variable(lit.var_index()).dlevel() <=
-                  variable(vid1).dlevel());
-        }
+    }
+  }
+  // every watch sits in the first two slots of its clause
+  for (unsigned i = 1; i < variables()->size(); ++i) {
+    for (unsigned j = 0; j < 2; ++j) {
+      vector<CWatch> & watched = variable(i).watched(j);
+      for (unsigned k = 0; k < watched.size(); ++k) {
+        CLitPoolElement * lits = watched[k].lits;
+        assert(lits[0].s_var() == (int)(i + i + j) ||
+               lits[1].s_var() == (int)(i + i + j));
       }
     }
   }
@@ -1058,7 +1164,7 @@ void CSolver::mark_vars(ClauseIdx cl, int var_idx) {
 int CSolver::analyze_conflicts(void) {
   assert(!_conflicts.empty());
   assert(_conflict_lits.size() == 0);
-  assert(_implication_queue.empty());
+  assert(implication_queue_empty());
   assert(_num_marked == 0);
   if (dlevel() == 0) {  // already at level 0. Conflict means unsat.
 #ifdef VERIFY_ON
@@ -1114,7 +1220,7 @@ int CSolver::finish_add_conf_clause(int gflag) {
   if (added_cl < 0) {  // memory out.
     _stats.is_mem_out = true;
     _conflicts.clear();
-    assert(_implication_queue.empty());
+    assert(implication_queue_empty());
     return 1;
   }
 
@@ -1245,10 +1351,10 @@ int CSolver::conflict_analysis_firstUIP(void) {
       cl = *ci;
       mark_vars(cl, -1);
       // current dl must be the conflict cl.
-      vector <int> & assignments = *_assignment_stack[dlevel()];
       // now add conflict lits, and unassign vars
-      for (int i = assignments.size() - 1; i >= 0; --i) {
-        int assigned = assignments[i];
+      for (int i = _trail.size() - 1, start = level_start(dlevel());
+           i >= start; --i) {
+        int assigned = _trail[i];
         if (variable(assigned >> 1).is_marked()) {
           // this variable is involved in the conflict clause or its antecedent
           variable(assigned>>1).clear_marked();
@@ -1295,9 +1401,9 @@ int CSolver::conflict_analysis_firstUIP(void) {
   _mark_increase_score = true;
   mark_vars(cl, -1);
   gflag = clause(cl).gflag();
-  vector <int> & assignments = *_assignment_stack[dlevel()];
-  for (int i = assignments.size() - 1; i >= 0; --i) {
-    int assigned = assignments[i];
+  for (int i = _trail.size() - 1, start = level_start(dlevel());
+       i >= start; --i) {
+    int assigned = _trail[i];
     if (variable(assigned >> 1).is_marked()) {
       variable(assigned>>1).clear_marked();
       --_num_marked;
@@ -1342,9 +1448,9 @@ void CSolver::print_cls(ostream & os) {
 int CSolver::mem_usage(void) {
   int mem_dbase = CDatabase::mem_usage();
   int mem_assignment = 0;
-  for (int i = 0; i < _stats.max_dlevel; ++i)
-    mem_assignment += _assignment_stack[i]->capacity() * sizeof(int);
-  mem_assignment += sizeof(vector<int>)* _assignment_stack.size();
+  mem_assignment += _trail.capacity() * sizeof(int);
+  mem_assignment += _level_start.capacity() * sizeof(int);
+  mem_assignment += _implication_queue.capacity() * sizeof(CImplication);
   return mem_dbase + mem_assignment;
 }
 
@@ -1364,16 +1470,25 @@ void CSolver::clean_up_dbase(void) {
   // 2. free up the mem for the vectors if possible
   for (unsigned i = 0; i < variables()->size(); ++i) {
     for (unsigned j = 0; j < 2; ++j) {  // both phase
-      vector<CLitPoolElement *> watched;
-      vector<CLitPoolElement *> & old_watched = variable(i).watched(j);
+      vector<CWatch> watched;
+      vector<CWatch> & old_watched = variable(i).watched(j);
       watched.reserve(old_watched.size());
-      for (vector<CLitPoolElement *>::iterator itr = old_watched.begin();
+      for (vector<CWatch>::iterator itr = old_watched.begin();
            itr != old_watched.end(); ++itr)
-        watched.push_back(*itr);
+        if (itr->lits->val() > 0)  // i.e. not deleted
+          watched.push_back(*itr);
         // because watched is a temp mem allocation, it will get deleted
         // out of the scope, but by swap it with the old_watched, the
         // contents are reserved.
         old_watched.swap(watched);
+      // the binary lists refer to clauses by index, so drop the deleted ones
+      vector<CBinary> binaries;
+      vector<CBinary> & old_binaries = variable(i).binaries(j);
+      for (vector<CBinary>::iterator itr = old_binaries.begin();
+           itr != old_binaries.end(); ++itr)
+        if (clause(itr->cl_idx).status() != DELETED_CL)
+          binaries.push_back(*itr);
+      old_binaries.swap(binaries);
 #ifdef KEEP_LIT_CLAUSES
         vector<int> lits_cls;
         vector<int> & old_lits_cls = variable(i).lit_clause(j);
@@ -148,6 +148,8 @@ struct CSolverStats {
   int           max_dlevel;
   int           random_seed;
   long64        num_implications;
+  long64        num_watch_visits;   // watch list entries visited by BCP
+  long64        num_blocker_hits;   // of those, skipped by a true blocker
   int           num_restarts;
   int           num_del_orig_cls;
 };
@@ -207,12 +209,14 @@ class CSolver:public CDatabase {
     CSolverStats        _stats;               // statistics and states
 
     int                 _dlevel;              // current decision elvel
-    vector<vector<int>*>_assignment_stack;
+    vector<int>         _trail;               // assigned literals, in order
+    vector<int>         _level_start;         // trail offset of each dlevel
     queue<int>          _recent_shrinkings;
     bool                _mark_increase_score;  // used in mark_vars during
                                               // multiple conflict analysis
     long64              _implication_id;
-    ImplicationQueue    _implication_queue;
+    vector<CImplication>_implication_queue;   // pending implications,
+    unsigned            _qhead;               // consumed up to _qhead
 
     // hook function run after certain number of decisions
     vector<pair<int, pair<HookFunPtrT, int> > > _hooks;
@@ -281,6 +285,7 @@ class CSolver:public CDatabase {
     void enable_cls_deletion(bool allow);
     void set_randomness(int n) ;
     void set_random_seed(int seed);
+    void set_verbosity(int n);
 
     void set_variable_number(int n);
     int add_variable(void) ;
@@ -331,6 +336,14 @@ class CSolver:public CDatabase {
       return _stats.num_implications;
     }
 
+    inline long64 num_watch_visits(void) {
+      return _stats.num_watch_visits;
+    }
+
+    inline long64 num_blocker_hits(void) {
+      return _stats.num_blocker_hits;
+    }
+
     inline long64 total_bubble_move(void) {
       return _stats.total_bubble_move;
     }
@@ -351,7 +364,27 @@ class CSolver:public CDatabase {
       CImplication i;
       i.lit = lit;
       i.antecedent = ante_clause;
-      _implication_queue.push(i);
+      _implication_queue.push_back(i);
+    }
+
+    bool implication_queue_empty(void) {
+      return _qhead == _implication_queue.size();
+    }
+
+    void clear_implication_queue(void) {
+      _implication_queue.clear();
+      _qhead = 0;
+    }
+
+    // levels are recorded lazily on the first assignment, so a level
+    // with nothing on the trail yet starts at the end of the trail
+    int level_start(int dl) {
+      return (unsigned)dl < _level_start.size() ? _level_start[dl] :
+        _trail.size();
+    }
+
+    int num_assigned_at(int dl) {
+      return level_start(dl + 1) - level_start(dl);
     }
 
     // top level function